@@ -0,0 +1,298 @@
+// Hash channel benchmark.  Measures the nexus hash building blocks and the cpu hash worker and prints the results as json.
+#include <string>
+#include <iostream>
+#include <vector>
+#include <array>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <asio/io_context.hpp>
+#include "hash/nexus_skein.hpp"
+#include "hash/nexus_keccak.hpp"
+#include "hash/hash_kernels.hpp"
+#include "hash/cpu_features.hpp"
+#include "LLC/hash/SK.h"
+#include "LLC/types/uint1024.h"
+#include "block.hpp"
+#include "worker.hpp"
+#include "config/config.hpp"
+#include "stats/stats_collector.hpp"
+#include "stats/types.hpp"
+#include "cpu/worker_hash.hpp"
+#include "cpu/hash_kernel.hpp"
+
+using json = nlohmann::json;
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+// synthetic hash channel block.  The values only need to be plausible.
+LLP::CBlock make_block()
+{
+	LLP::CBlock block;
+	block.nVersion = 4;
+	block.nChannel = 2;
+	block.nHeight = 2023276;
+	block.nBits = 0x7b032ed8;
+	block.nNonce = 0;
+	block.hashPrevBlock.SetHex("0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"
+		"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef");
+	block.hashMerkleRoot.SetHex("fedcba9876543210fedcba9876543210fedcba9876543210fedcba9876543210");
+	return block;
+}
+
+// run op until duration has passed and return the time per call in ns
+double time_ns(std::function<void()> const& op, std::chrono::milliseconds duration)
+{
+	std::uint64_t calls = 0;
+	auto const start = Clock::now();
+	auto elapsed = Clock::duration{};
+	do
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			op();
+		}
+		calls += 16;
+		elapsed = Clock::now() - start;
+	} while (elapsed < duration);
+	return std::chrono::duration<double, std::nano>(elapsed).count() / calls;
+}
+
+// total hashes per second of the kernel running on thread_count threads
+double kernel_rate(HashKernel const& kernel, NexusSkein const& skein, unsigned thread_count, std::chrono::milliseconds duration)
+{
+	std::atomic<bool> stop{ false };
+	std::vector<std::uint64_t> hash_counts(thread_count, 0);
+	std::vector<std::thread> threads;
+	auto const start = Clock::now();
+	for (unsigned t = 0; t < thread_count; t++)
+	{
+		threads.emplace_back([&, t]()
+		{
+			NexusSkein thread_skein = skein;
+			//the mining loop with the cpu worker's leading zero filter
+			std::vector<NexusSkein::Candidate> candidates;
+			std::uint64_t const batch_size = 1024;
+			std::uint64_t hash_count = 0;
+			while (!stop.load(std::memory_order_relaxed))
+			{
+				(thread_skein.*kernel.hashRange)((static_cast<std::uint64_t>(t) << 48) + hash_count, batch_size, ~0ULL >> 20, candidates);
+				hash_count += batch_size;
+			}
+			hash_counts[t] = hash_count;
+		});
+	}
+	std::this_thread::sleep_for(duration);
+	stop = true;
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	double const seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	std::uint64_t total = 0;
+	for (auto hash_count : hash_counts)
+	{
+		total += hash_count;
+	}
+	return total / seconds;
+}
+
+std::vector<unsigned> thread_steps(unsigned max_threads)
+{
+	std::vector<unsigned> steps;
+	for (unsigned threads = 1; threads < max_threads; threads *= 2)
+	{
+		steps.push_back(threads);
+	}
+	steps.push_back(max_threads);
+	return steps;
+}
+
+json bench_building_blocks(std::chrono::milliseconds duration)
+{
+	nexusminer::Block_data block_data{ make_block() };
+	auto header = block_data.GetHeaderBytes();
+	NexusSkein skein;
+	skein.setMessage(header);
+	std::uint64_t nonce = 0;
+	std::uint64_t checksum = 0;
+
+	json result;
+	result["get_header_bytes_ns"] = time_ns([&]() { checksum += block_data.GetHeaderBytes()[0]; }, duration);
+	nexusminer::Block_data::Header_bytes header_bytes;
+	result["write_header_bytes_ns"] = time_ns([&]() { checksum += block_data.WriteHeaderBytes(header_bytes); }, duration);
+	result["set_message_ns"] = time_ns([&]() { skein.setMessage(header); }, duration);
+	result["write_header_set_message_ns"] = time_ns([&]()
+	{
+		auto const length = block_data.WriteHeaderBytes(header_bytes);
+		skein.setMessage(header_bytes.data(), length);
+	}, duration);
+
+	NexusSkein::stateType state;
+	result["int_array"]["from_bytes_ns"] = time_ns([&]() { state.fromBytes(header); }, duration);
+	result["int_array"]["to_bytes_ns"] = time_ns([&]() { checksum += state.toBytes()[0]; }, duration);
+
+	result["nexus_skein_ns"] = time_ns([&]()
+	{
+		skein.setNonce(nonce++);
+		skein.calculateHash();
+	}, duration);
+	auto const skein_hash = skein.getHash();
+	result["nexus_keccak_ns"] = time_ns([&]()
+	{
+		NexusKeccak keccak(skein_hash);
+		keccak.calculateHash();
+		checksum += keccak.getResult();
+	}, duration);
+	result["nexus_keccak_mining_ns"] = time_ns([&]()
+	{
+		NexusKeccak keccak(skein_hash);
+		checksum += keccak.calculateResult();
+	}, duration);
+	result["sk1024_ns"] = time_ns([&]()
+	{
+		header[header.size() - 1] = static_cast<unsigned char>(nonce++);
+		uint1024_t hash = LLC::SK1024(header.begin(), header.end());
+		checksum += hash.Get64(15);
+	}, duration);
+	result["checksum"] = checksum;
+	return result;
+}
+
+json bench_kernels(unsigned max_threads, std::chrono::milliseconds duration)
+{
+	nexusminer::Block_data block_data{ make_block() };
+	NexusSkein skein;
+	skein.setMessage(block_data.GetHeaderBytes());
+
+	json kernels = json::array();
+	for (auto const& kernel : getHashKernels())
+	{
+		json result;
+		result["name"] = kernel.name;
+		result["lanes"] = kernel.lanes;
+		result["supported"] = kernel.supported;
+		if (!kernel.supported)
+		{
+			kernels.push_back(result);
+			continue;
+		}
+		result["self_test"] = nexusminer::cpu::hash_kernel_self_test(kernel);
+
+		json scaling = json::array();
+		for (auto threads : thread_steps(max_threads))
+		{
+			double const rate = kernel_rate(kernel, skein, threads, duration);
+			scaling.push_back({ {"threads", threads}, {"hashes_per_second", rate}, {"hashes_per_second_per_thread", rate / threads} });
+			if (threads == 1)
+			{
+				result["ns_per_hash"] = 1.0e9 / rate;
+				result["hashes_per_second"] = rate;
+			}
+		}
+		result["scaling"] = scaling;
+		kernels.push_back(result);
+	}
+	return kernels;
+}
+
+// the complete cpu hash worker (kernel selection, set_block, hashing threads, statistics)
+json bench_worker(unsigned threads, std::chrono::milliseconds duration)
+{
+	using namespace nexusminer;
+	auto logger = spdlog::get("logger");
+	config::Config config{ logger };
+	config::Worker_config worker_config;
+	worker_config.m_id = "bench";
+	worker_config.m_internal_id = 0;
+	worker_config.m_mode = config::Worker_mode::CPU;
+	config::Worker_config_cpu worker_config_cpu;
+	worker_config_cpu.m_threads = static_cast<std::uint16_t>(threads);
+	worker_config.m_worker_mode = worker_config_cpu;
+	config.get_worker_config().push_back(worker_config);
+	stats::Collector collector{ config };
+
+	auto io_context = std::make_shared<::asio::io_context>();
+	auto worker = std::make_shared<cpu::Worker_hash>(io_context, config.get_worker_config()[0], std::make_shared<Nonce_allocator>());
+
+	auto const set_block_start = Clock::now();
+	worker->set_block(make_block(), 0, {}, set_block_start);
+	double const set_block_ns = std::chrono::duration<double, std::nano>(Clock::now() - set_block_start).count();
+
+	//let the threads get going before measuring
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	worker->update_statistics(collector);
+	auto const start_count = std::get<stats::Hash>(collector.get_worker_stats(0)).m_hash_count;
+	auto const start = Clock::now();
+	std::this_thread::sleep_for(duration);
+	worker->update_statistics(collector);
+	auto const end_stats = std::get<stats::Hash>(collector.get_worker_stats(0));
+	auto const end_count = end_stats.m_hash_count;
+	//the threads pick up the first block from set_block.  One block so p50, p99 and max are the same.
+	auto const block_switch_us = end_stats.m_max_block_switch_us;
+	double const seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	double const rate = (end_count - start_count) / seconds;
+
+	return { {"threads", threads}, {"set_block_ns", set_block_ns}, {"max_block_switch_us", block_switch_us}, {"hashes_per_second", rate}, {"hashes_per_second_per_thread", rate / threads} };
+}
+
+void show_usage(std::string const& name)
+{
+	std::cerr << "Usage: " << name << " <option(s)>\n"
+		<< "Options:\n"
+		<< "\t-h,--help\tShow this help message\n"
+		<< "\t-d,--duration\tMilliseconds per measurement (default 500)\n"
+		<< "\t-t,--threads\tMaximum number of threads (default one per logical core)"
+		<< std::endl;
+}
+}
+
+int main(int argc, char** argv)
+{
+	std::chrono::milliseconds duration{ 500 };
+	unsigned max_threads = std::max(1U, std::thread::hardware_concurrency());
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if ((arg == "-h") || (arg == "--help"))
+		{
+			show_usage(argv[0]);
+			return 0;
+		}
+		else if (((arg == "-d") || (arg == "--duration")) && i + 1 < argc)
+		{
+			duration = std::chrono::milliseconds{ std::stoul(argv[++i]) };
+		}
+		else if (((arg == "-t") || (arg == "--threads")) && i + 1 < argc)
+		{
+			max_threads = std::max(1UL, std::stoul(argv[++i]));
+		}
+		else
+		{
+			show_usage(argv[0]);
+			return -1;
+		}
+	}
+
+	//the json result goes to stdout.  Keep the log on stderr.
+	auto logger = spdlog::stderr_color_mt("logger");
+	logger->set_level(spdlog::level::warn);
+
+	auto const& cpu_features = getCpuFeatures();
+	json result;
+	result["hardware_concurrency"] = std::thread::hardware_concurrency();
+	result["duration_ms"] = duration.count();
+	result["cpu_features"] = { {"sse2", cpu_features.sse2}, {"avx2", cpu_features.avx2}, {"avx512", cpu_features.avx512} };
+	result["building_blocks"] = bench_building_blocks(duration);
+	result["kernels"] = bench_kernels(max_threads, duration);
+	result["worker"] = bench_worker(max_threads, duration);
+
+	std::cout << result.dump(4) << std::endl;
+	return 0;
+}
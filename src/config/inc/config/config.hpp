@@ -35,6 +35,9 @@ public:
 	std::uint16_t get_print_statistics_interval() const { return m_print_statistics_interval; }
 	std::uint16_t get_height_interval() const { return m_get_height_interval; }
 	std::uint16_t get_ping_interval() const { return m_ping_interval; }
+	std::uint16_t get_watchdog_interval() const { return m_watchdog_interval; }
+	std::uint16_t get_watchdog_stall_factor() const { return m_watchdog_stall_factor; }
+	bool get_watchdog_fpga() const { return m_watchdog_fpga; }
 	std::vector<Worker_config>& get_worker_config() { return m_worker_config; }
 	std::vector<Stats_printer_config>& get_stats_printer_config() { return m_stats_printer_config; }
 	Pool const& get_pool_config() const { return m_pool_config; }
@@ -67,6 +70,9 @@ private:
 	std::uint16_t m_print_statistics_interval;
 	std::uint16_t m_get_height_interval;
 	std::uint16_t m_ping_interval;
+	std::uint16_t m_watchdog_interval;		// seconds between stalled worker checks. 0 = off
+	std::uint16_t m_watchdog_stall_factor;	// stalled after this many times the usual time between progress
+	bool m_watchdog_fpga;					// also watch fpga workers.  Their nonce candidates come in random bursts
 
 };
 }
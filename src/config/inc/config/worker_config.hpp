@@ -3,6 +3,7 @@
 
 #include <string>
 #include <variant>
+#include <vector>
 #include "config/types.hpp"
 
 namespace nexusminer
@@ -11,7 +12,12 @@ namespace config
 {
 struct Worker_config_cpu
 {
-
+	std::uint16_t m_threads{0};		// number of mining threads. 0 = std::thread::hardware_concurrency()
+	std::string m_kernel{};			// hash kernel (scalar, sse2, avx2, avx512). empty = fastest supported
+	std::uint32_t m_verify_interval{0};	// recompute 1 in n hashes with the reference hash. 0 = off
+	std::vector<std::uint16_t> m_cpu_set{};	// cpus the mining threads are pinned to. empty = not pinned
+	int m_numa_node{-1};			// pin the mining threads to the cpus of this numa node. -1 = any node
+	bool m_isolate_io_thread{false};	// keep the network (io) thread off the cpus of this worker
 };
 
 struct Worker_config_fpga
@@ -23,6 +29,7 @@ struct Worker_config_fpga
 struct Worker_config_gpu
 {
 	std::uint16_t m_device;
+	std::uint32_t m_verify_interval{0};	// recompute 1 nonce in about n hashes with the reference hash. 0 = off
 };
 
 class Worker_config
@@ -25,6 +25,9 @@ namespace config
 		, m_print_statistics_interval{5}
 		, m_get_height_interval{2}
 		, m_ping_interval{10}
+		, m_watchdog_interval{10}
+		, m_watchdog_stall_factor{5}
+		, m_watchdog_fpga{false}
 	{
 	}
 
@@ -112,6 +115,18 @@ namespace config
 			{
 				j.at("ping_interval").get_to(m_ping_interval);
 			}
+			if (j.count("watchdog_interval") != 0)
+			{
+				j.at("watchdog_interval").get_to(m_watchdog_interval);
+			}
+			if (j.count("watchdog_stall_factor") != 0)
+			{
+				j.at("watchdog_stall_factor").get_to(m_watchdog_stall_factor);
+			}
+			if (j.count("watchdog_fpga") != 0)
+			{
+				j.at("watchdog_fpga").get_to(m_watchdog_fpga);
+			}
 
 			if (j.count("log_level") != 0)
 			{
@@ -179,12 +194,42 @@ namespace config
 				if(worker_mode_json["hardware"] == "cpu")
 				{
 					worker_config.m_mode = Worker_mode::CPU;
-					worker_config.m_worker_mode = Worker_config_cpu{};
+					Worker_config_cpu worker_config_cpu{};
+					if (worker_mode_json.count("threads") != 0)
+					{
+						worker_mode_json.at("threads").get_to(worker_config_cpu.m_threads);
+					}
+					if (worker_mode_json.count("kernel") != 0)
+					{
+						worker_mode_json.at("kernel").get_to(worker_config_cpu.m_kernel);
+					}
+					if (worker_mode_json.count("verify_interval") != 0)
+					{
+						worker_mode_json.at("verify_interval").get_to(worker_config_cpu.m_verify_interval);
+					}
+					if (worker_mode_json.count("cpu_set") != 0)
+					{
+						worker_mode_json.at("cpu_set").get_to(worker_config_cpu.m_cpu_set);
+					}
+					if (worker_mode_json.count("numa_node") != 0)
+					{
+						worker_mode_json.at("numa_node").get_to(worker_config_cpu.m_numa_node);
+					}
+					if (worker_mode_json.count("isolate_io_thread") != 0)
+					{
+						worker_mode_json.at("isolate_io_thread").get_to(worker_config_cpu.m_isolate_io_thread);
+					}
+					worker_config.m_worker_mode = worker_config_cpu;
 				}
 				else if(worker_mode_json["hardware"] == "gpu")
 				{
 					worker_config.m_mode = Worker_mode::GPU;
-					worker_config.m_worker_mode = Worker_config_gpu{ worker_mode_json["device"] };
+					Worker_config_gpu worker_config_gpu{ worker_mode_json["device"] };
+					if (worker_mode_json.count("verify_interval") != 0)
+					{
+						worker_mode_json.at("verify_interval").get_to(worker_config_gpu.m_verify_interval);
+					}
+					worker_config.m_worker_mode = worker_config_gpu;
 				}
 				else if(worker_mode_json["hardware"] == "fpga")
 				{
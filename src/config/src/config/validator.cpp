@@ -2,6 +2,7 @@
 #include "config/types.hpp"
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -147,6 +148,41 @@ bool Validator::check(std::string const& config_file)
                         }
                     }
 
+                    if (worker_mode_json["hardware"] == "cpu")
+                    {
+                        if (worker_mode_json.count("threads") != 0 && !worker_mode_json["threads"].is_number())
+                        {
+                            m_optional_fields.push_back(Validator_error{ "workers/worker/mode/threads", "Not a number" });
+                        }
+                        if (worker_mode_json.count("kernel") != 0 && !worker_mode_json["kernel"].is_string())
+                        {
+                            m_optional_fields.push_back(Validator_error{ "workers/worker/mode/kernel", "Not a string" });
+                        }
+                        if (worker_mode_json.count("verify_interval") != 0 && !worker_mode_json["verify_interval"].is_number_unsigned())
+                        {
+                            m_optional_fields.push_back(Validator_error{ "workers/worker/mode/verify_interval", "Not a positive number" });
+                        }
+                        if (worker_mode_json.count("cpu_set") != 0)
+                        {
+                            auto const& cpu_set_json = worker_mode_json["cpu_set"];
+                            if (!cpu_set_json.is_array() || !std::all_of(cpu_set_json.begin(), cpu_set_json.end(),
+                                [](auto const& cpu) { return cpu.is_number_unsigned(); }))
+                            {
+                                m_optional_fields.push_back(Validator_error{ "workers/worker/mode/cpu_set", "Not an array of positive numbers" });
+                            }
+                        }
+                        //-1 = no numa binding (the default)
+                        if (worker_mode_json.count("numa_node") != 0 && !worker_mode_json["numa_node"].is_number_unsigned() &&
+                            !(worker_mode_json["numa_node"].is_number_integer() && worker_mode_json["numa_node"] == -1))
+                        {
+                            m_optional_fields.push_back(Validator_error{ "workers/worker/mode/numa_node", "Not a positive number or -1" });
+                        }
+                        if (worker_mode_json.count("isolate_io_thread") != 0 && !worker_mode_json["isolate_io_thread"].is_boolean())
+                        {
+                            m_optional_fields.push_back(Validator_error{ "workers/worker/mode/isolate_io_thread", "Not a boolean" });
+                        }
+                    }
+
                     if (worker_mode_json["hardware"] == "gpu")
                     {
                        
@@ -162,6 +198,10 @@ bool Validator::check(std::string const& config_file)
                                 m_mandatory_fields.push_back(Validator_error{ "workers/worker/mode/device", "Not a number" });
                             }
                         }
+                        if (worker_mode_json.count("verify_interval") != 0 && !worker_mode_json["verify_interval"].is_number_unsigned())
+                        {
+                            m_optional_fields.push_back(Validator_error{ "workers/worker/mode/verify_interval", "Not a positive number" });
+                        }
                     }
                 }
             }
@@ -196,6 +236,27 @@ bool Validator::check(std::string const& config_file)
                 m_optional_fields.push_back(Validator_error{ "ping_interval", "Not a number" });
             }
         }
+        if (j.count("watchdog_interval") != 0)
+        {
+            if (!j.at("watchdog_interval").is_number_unsigned())
+            {
+                m_optional_fields.push_back(Validator_error{ "watchdog_interval", "Not a positive number" });
+            }
+        }
+        if (j.count("watchdog_stall_factor") != 0)
+        {
+            if (!j.at("watchdog_stall_factor").is_number_unsigned() || j.at("watchdog_stall_factor") == 0)
+            {
+                m_optional_fields.push_back(Validator_error{ "watchdog_stall_factor", "Not a number greater than 0" });
+            }
+        }
+        if (j.count("watchdog_fpga") != 0)
+        {
+            if (!j.at("watchdog_fpga").is_boolean())
+            {
+                m_optional_fields.push_back(Validator_error{ "watchdog_fpga", "Not a boolean" });
+            }
+        }
     }
     catch(const std::exception& e)
     {
@@ -0,0 +1,23 @@
+#ifndef NEXUSMINER_CPU_CACHE_SIZES_HPP
+#define NEXUSMINER_CPU_CACHE_SIZES_HPP
+
+#include <cstdint>
+
+namespace nexusminer
+{
+namespace cpu
+{
+// Data cache sizes in bytes of the cpu the calling thread runs on.  Call after pinning the thread.
+struct Cache_sizes
+{
+	std::uint32_t m_l1d{32768};
+	std::uint32_t m_l2{262144};
+};
+
+// From sysfs on Linux, CPUID on x86 otherwise.  A size that can't be detected keeps its default.
+Cache_sizes get_cache_sizes();
+
+}
+}
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef NEXUSMINER_CPU_HASH_KERNEL_HPP
+#define NEXUSMINER_CPU_HASH_KERNEL_HPP
+
+#include "hash/hash_kernels.hpp"
+#include <spdlog/spdlog.h>
+#include <string>
+
+namespace nexusminer
+{
+namespace cpu
+{
+// Pick the mining kernel for the cpu hash worker. An empty name selects the fastest kernel the cpu supports.
+// Every kernel has to pass a known answer test against LLC::SK1024 before it is used.
+// The chosen kernel and its single thread hash rate are logged.
+HashKernel const& select_hash_kernel(std::string const& name, spdlog::logger& logger, std::string const& log_leader);
+
+// known answer test of the kernel against the reference hash
+bool hash_kernel_self_test(HashKernel const& kernel);
+
+// single thread hashes per second of the kernel
+double measure_hash_kernel(HashKernel const& kernel);
+
+}
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef NEXUSMINER_CPU_HASH_VERIFIER_HPP
+#define NEXUSMINER_CPU_HASH_VERIFIER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "worker.hpp"
+#include <spdlog/spdlog.h>
+
+namespace nexusminer
+{
+namespace cpu
+{
+// Recomputes sampled hashes of the optimised kernels with LLC::SK1024 on a background thread.
+// The hashing threads only pay for a queue push per sample.  Samples are dropped if the queue is full.
+class Hash_verifier
+{
+public:
+
+    Hash_verifier(std::shared_ptr<spdlog::logger> logger, std::string log_leader);
+    ~Hash_verifier();
+
+    // header is the 216 byte block header (the nonce is overwritten), result the upper 64 bits of the hash from the kernel
+    void submit(std::shared_ptr<Block_data::Header_bytes const> header, std::uint64_t nonce, std::uint64_t result);
+
+    std::uint32_t get_error_count() const { return m_error_count.load(std::memory_order_relaxed); }
+    std::uint64_t get_verified_count() const { return m_verified_count.load(std::memory_order_relaxed); }
+    void reset_statistics();
+
+private:
+
+    struct Sample
+    {
+        std::shared_ptr<Block_data::Header_bytes const> m_header;
+        std::uint64_t m_nonce;
+        std::uint64_t m_result;
+    };
+
+    static constexpr std::size_t max_queued_samples = 1024;
+
+    void run();
+
+    std::shared_ptr<spdlog::logger> m_logger;
+    std::string m_log_leader;
+    std::mutex m_mtx;
+    std::condition_variable m_cv;
+    std::deque<Sample> m_samples;
+    bool m_stop;
+    std::atomic<std::uint32_t> m_error_count;
+    std::atomic<std::uint64_t> m_verified_count;
+    std::thread m_thread;
+};
+
+}
+}
+
+#endif
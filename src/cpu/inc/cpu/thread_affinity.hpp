@@ -0,0 +1,48 @@
+#ifndef NEXUSMINER_CPU_THREAD_AFFINITY_HPP
+#define NEXUSMINER_CPU_THREAD_AFFINITY_HPP
+
+#include "config/worker_config.hpp"
+#include <spdlog/spdlog.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nexusminer
+{
+namespace cpu
+{
+// Where the mining threads of a cpu worker run.  Resolved once from the worker config.
+struct Thread_placement
+{
+	std::vector<std::uint16_t> m_cpus{};	// cpus the threads are pinned to. empty = not pinned
+	int m_numa_node{-1};			// numa node of the cpus. -1 = not requested
+
+	// "cpus 0-3,8 numa node 0".  empty if the threads are not pinned
+	std::string to_string() const;
+};
+
+// Combine cpu_set and numa_node of the config.  With both set only the cpus of the set on that node are used.
+// Problems (unknown node, no cpu left) are logged and the threads stay unpinned.
+Thread_placement get_thread_placement(config::Worker_config_cpu const& config, spdlog::logger& logger, std::string const& log_leader);
+
+// The cpus left for the network (io) thread when at least one cpu worker asks for isolate_io_thread.
+// Empty if no worker asks for it or the workers use every cpu.
+std::vector<std::uint16_t> get_io_thread_cpus(std::vector<config::Worker_config> const& worker_config, spdlog::logger& logger);
+
+// Restrict the calling thread to the cpus (pthread_setaffinity_np).  Memory the thread touches first afterwards
+// is allocated on the numa node of those cpus.  Returns false if pinning failed or is not supported on this os.
+bool set_thread_affinity(std::vector<std::uint16_t> const& cpus);
+
+// cpus of the numa node as reported by the os.  Empty if unknown.
+std::vector<std::uint16_t> get_numa_node_cpus(int numa_node);
+
+// cpus this process is allowed to run on
+std::vector<std::uint16_t> get_available_cpus();
+
+// "0-3,8"
+std::string format_cpu_list(std::vector<std::uint16_t> const& cpus);
+
+}
+}
+
+#endif
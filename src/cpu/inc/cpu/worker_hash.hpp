@@ -5,10 +5,16 @@
 #include <memory>
 #include <thread>
 #include <atomic>
-#include <mutex>
+#include <vector>
 #include "worker.hpp"
+#include "work_slot.hpp"
+#include "result_reporter.hpp"
+#include "nonce_allocator.hpp"
 #include "hash/nexus_skein.hpp"
 #include "hash/nexus_keccak.hpp"
+#include "hash/hash_kernels.hpp"
+#include "cpu/hash_verifier.hpp"
+#include "cpu/thread_affinity.hpp"
 #include <spdlog/spdlog.h>
 
 namespace asio { class io_context; }
@@ -25,40 +31,78 @@ public:
 
     using Worker_config = config::Worker_config;
 
-    Worker_hash(std::shared_ptr<asio::io_context> io_context, Worker_config& config);
+    Worker_hash(std::shared_ptr<asio::io_context> io_context, Worker_config& config, std::shared_ptr<Nonce_allocator> nonce_allocator);
     ~Worker_hash();
 
     // Sets a new block (nexus data type) for the miner worker. The miner worker must reset the current work.
     // When  the worker finds a new block, the BlockFoundHandler has to be called with the found BlockData
-    void set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result) override;
+    void set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result, Clock::time_point received) override;
     void update_statistics(stats::Collector& stats_collector) override;
+    void stop() override;
 
 private:
 
-    void run();
-    bool difficulty_check();
-    std::uint64_t leading_zero_mask();  
+    //everything the hashing threads need for one block.  Never modified after it is published by set_block.
+    //the threads pick it up from m_work between two batches.
+    struct Work
+    {
+        NexusSkein m_skein;
+        Block_data m_block;
+        Block_data::Header_bytes m_header;
+        //the pool or network target decoded once per block.  A hash meets it if the upper 64 bits are <= m_target64.
+        int m_leading_zeros_required;
+        std::uint64_t m_target64;
+        Worker::Block_found_handler m_found_nonce_callback;
+    };
+
+    //per thread counters.  Each on its own cache line so the hashing threads never write to a shared line.
+    struct alignas(64) Thread_stats
+    {
+        std::atomic<std::uint64_t> m_hash_count{0};
+    };
+
+    //the hashing threads live as long as the worker.  run waits for work and calls mine until it is replaced.
+    void run(std::uint16_t thread_index);
+    void mine(std::uint16_t thread_index, std::shared_ptr<Work const> const& work, std::uint64_t generation);
+    bool difficulty_check(Work const& work, NexusSkein::Candidate const& candidate);
+    //mining threads queue found nonces in m_results.  The io thread submits the ones that still match the current work.
+    void submit_result(Result const& result);
  
 
-    //Poor man's difficulty.  Report any nonces with at least this many leading zeros. Let the software perform additional filtering. 
-    static constexpr int leading_zeros_required = 20;    //set lower to find more nonce candidates
+    //Nonces with at least this many leading zeros update the best leading zeros statistic even if they miss the target.
+    static constexpr int best_leading_zeros_reported = 20;
+    //nonces per call to the hash range kernel.  The threads check for new work and update the hash count once per batch.
+    static constexpr std::uint64_t hash_batch_size = 1024;
+    //first lease of a thread, until the allocator knows its hash rate.  Later leases last about nonce_lease_duration.
+    static constexpr std::uint64_t initial_lease_size = 1024 * hash_batch_size;
+    static constexpr std::chrono::milliseconds nonce_lease_duration{1000};
+    //found nonces that can wait for the io thread.  More are dropped until it catches up.
+    static constexpr std::size_t result_ring_size = 256;
 
     std::shared_ptr<asio::io_context> m_io_context;
     std::shared_ptr<spdlog::logger> m_logger;
     Worker_config& m_config;
-    std::atomic<bool> m_stop;
-    std::thread m_run_thread;
-    Worker::Block_found_handler m_found_nonce_callback;
-    NexusSkein m_skein;
-    Block_data m_block;
-    std::mutex m_mtx;
-    uint64_t m_starting_nonce = 0;
+    Work_slot<Work> m_work;
     std::string m_log_leader;
+    Result_reporter<Work, result_ring_size> m_results;
+    //cpus the hashing threads are pinned to (cpu_set / numa_node config)
+    Thread_placement m_placement;
+    std::uint16_t m_thread_count;
+    //each thread leases its own nonce ranges.  m_nonce_consumers[thread_index] is the consumer id of the thread.
+    std::shared_ptr<Nonce_allocator> m_nonce_allocator;
+    std::vector<std::size_t> m_nonce_consumers;
+    //mining kernel chosen at startup from the cpu features (or the config)
+    HashKernel const* m_kernel;
+    std::vector<std::thread> m_run_threads;
+    //recompute 1 in m_verify_interval hashes with the reference hash. 0 = off
+    std::uint32_t m_verify_interval;
+    std::unique_ptr<Hash_verifier> m_verifier;
  
     void reset_statistics();
-    std::uint64_t m_hash_count;
-    int m_best_leading_zeros;
-    int m_met_difficulty_count;
+    //per thread hash counters.  summed up in update_statistics without stopping the threads
+    std::vector<Thread_stats> m_thread_stats;
+    std::atomic<int> m_best_leading_zeros;
+    std::atomic<int> m_met_difficulty_count;
 
     std::uint32_t m_pool_nbits;
 
@@ -6,9 +6,18 @@
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <future>
 #include "worker.hpp"
+#include "work_slot.hpp"
+#include "result_reporter.hpp"
+#include "nonce_allocator.hpp"
 #include "hash/nexus_skein.hpp"
 #include "hash/nexus_keccak.hpp"
+#include "cpu/thread_affinity.hpp"
+#include "cpu/cache_sizes.hpp"
 #include <boost/multiprecision/cpp_int.hpp>
 #include <spdlog/spdlog.h>
 #include "LLC/types/bignum.h"
@@ -28,18 +37,54 @@ class Worker_prime : public Worker, public std::enable_shared_from_this<Worker_p
 {
 public:
 
-    Worker_prime(std::shared_ptr<asio::io_context> io_context, config::Worker_config& config);
+    Worker_prime(std::shared_ptr<asio::io_context> io_context, config::Worker_config& config,
+        std::shared_ptr<Nonce_allocator> nonce_allocator);
     ~Worker_prime() noexcept override;
 
-    void set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result) override;
+    void set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result, Clock::time_point received) override;
     void update_statistics(stats::Collector& stats_collector) override;
+    void stop() override;
 
 private:
 
-    void run();
+    //everything the mining thread needs for one block.  Never modified after it is published by set_block.
+    struct Work
+    {
+        Block_data m_block;
+        uint1k m_base_hash;
+        std::uint32_t m_difficulty;
+        Worker::Block_found_handler m_found_nonce_callback;
+    };
+
+    //A lease of sieve offsets split into one chunk of consecutive segments per thread.  The threads sieve their chunks
+    //in parallel.  Chains crossing from one chunk into the next are finished by the thread of the lower chunk with the
+    //handoff (first bytes of the next chunk) published by the thread of the upper chunk.
+    struct Round
+    {
+        std::uint64_t m_first{0};
+        std::uint64_t m_chunk_size{0};
+        std::vector<std::vector<std::uint8_t>> m_handoff;
+        std::vector<bool> m_handoff_ready;
+        std::uint16_t m_finished{0};
+    };
+
+    //the mining threads live as long as the worker.  run pins the thread, creates its sieve, signals sieve_ready
+    //and then waits for work and calls mine until it is replaced.
+    void run(std::uint16_t thread_index, std::promise<void> sieve_ready);
+    void mine(std::uint16_t thread_index, Work const& work, std::uint64_t generation);
+    //first sieve offset and size of the chunk of the thread in the round.  The first thread to get to a round leases it.
+    //false if the work was replaced.
+    bool get_chunk(std::uint16_t thread_index, std::uint64_t round, std::uint64_t generation, std::uint64_t& first, std::uint64_t& size);
+    void publish_handoff(std::uint16_t thread_index, std::uint64_t round, std::uint64_t generation, std::vector<std::uint8_t> handoff);
+    //waits for the handoff of the next chunk.  false if the work was replaced.
+    bool wait_handoff(std::uint16_t thread_index, std::uint64_t round, std::uint64_t generation, std::vector<std::uint8_t>& handoff);
+    void finish_round(std::uint64_t round, std::uint64_t generation);
+    //point the sieve at base_hash + nonce and calculate the starting multiples.  Returns the nonce of the actual sieve start.
+    std::uint64_t start_sieve(Sieve& sieve, uint1k const& base_hash, std::uint64_t nonce);
+    //the mining thread queues found chains in m_results.  The io thread submits the ones that still match the current work.
+    void submit_result(Result const& result);
     double getDifficulty(uint1k p);
-    double getNetworkDifficulty();
-    bool difficulty_check(uint1k p);
+    double getNetworkDifficulty(std::uint32_t nbits);
     //std::uint64_t leading_zero_mask();
     bool isPrime(uint1k p);
     void fermat_performance_test();
@@ -51,15 +96,31 @@ private:
     std::shared_ptr<spdlog::logger> m_logger;
     config::Worker_config& m_config;
     std::unique_ptr<Prime> m_prime_helper;
-    std::atomic<bool> m_stop;
-    std::thread m_run_thread;
-    Worker::Block_found_handler m_found_nonce_callback;
-    std::unique_ptr<Sieve> m_segmented_sieve;
-
-    Block_data m_block;
-    std::mutex m_mtx;
-    std::uint64_t m_starting_nonce = 0;
+    Work_slot<Work> m_work;
+
     std::string m_log_leader;
+    //found chains that can wait for the io thread
+    Result_reporter<Work, 16> m_results;
+    //cpus the mining threads are pinned to (cpu_set / numa_node config)
+    Thread_placement m_placement;
+    std::uint16_t m_thread_count;
+    std::vector<std::thread> m_run_threads;
+    //one sieve per thread.  They share the sieving primes of the first one.
+    std::vector<std::unique_ptr<Sieve>> m_sieves;
+    //caches of the cpu of the first thread.  All sieves use the same segment size so the chunks of a round line up.
+    Cache_sizes m_cache_sizes;
+    //sieve offsets are leased in whole segments per thread.  Every new lease costs a calculation of the starting multiples
+    //so the leases are long.  The segments are about L2 sized.
+    static constexpr std::uint64_t initial_lease_segments = 256;
+    static constexpr std::chrono::milliseconds nonce_lease_duration{60000};
+    std::shared_ptr<Nonce_allocator> m_nonce_allocator;
+    std::size_t m_nonce_consumer{0};
+    //the rounds not finished by all threads yet.  m_rounds[0] is round m_first_round of work m_round_generation.
+    std::mutex m_round_mtx;
+    std::condition_variable m_round_cv;
+    std::deque<Round> m_rounds;
+    std::uint64_t m_first_round{0};
+    std::uint64_t m_round_generation{0};
 
     void reset_statistics();
     std::uint32_t m_primes{ 0 };
@@ -68,9 +129,6 @@ private:
 
     std::uint32_t m_pool_nbits;
 
-    std::uint64_t m_nonce = 0;
-    uint1k m_base_hash;
-
 
     void generate_seive(uint1k);
     void analyze_chains();
@@ -98,7 +156,7 @@ private:
 
     //stats
     std::vector<std::uint32_t> m_chain_histogram;
-    uint64_t m_range_searched = 0;
+    std::atomic<std::uint64_t> m_range_searched{0};
 
 };
 }
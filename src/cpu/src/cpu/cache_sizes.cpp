@@ -0,0 +1,128 @@
+#include "cpu/cache_sizes.hpp"
+#include "hash/cpu_features.hpp"
+#include <exception>
+#include <fstream>
+#include <string>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace nexusminer
+{
+namespace cpu
+{
+
+namespace
+{
+//parse a kernel cache size like "48K" or "2M"
+std::uint32_t parse_cache_size(std::string const& size)
+{
+	try
+	{
+		std::size_t end = 0;
+		auto value = std::stoul(size, &end);
+		if (end < size.size() && size[end] == 'K')
+		{
+			value *= 1024;
+		}
+		else if (end < size.size() && size[end] == 'M')
+		{
+			value *= 1024 * 1024;
+		}
+		return static_cast<std::uint32_t>(value);
+	}
+	catch (std::exception const&)
+	{
+		return 0;
+	}
+}
+
+bool get_sysfs_cache_sizes(Cache_sizes& cache_sizes)
+{
+	bool found = false;
+#if defined(__linux__)
+	auto const cpu = sched_getcpu();
+	std::string const cache_dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu < 0 ? 0 : cpu) + "/cache/index";
+	for (int index = 0; ; index++)
+	{
+		std::ifstream level_file(cache_dir + std::to_string(index) + "/level");
+		std::ifstream type_file(cache_dir + std::to_string(index) + "/type");
+		std::ifstream size_file(cache_dir + std::to_string(index) + "/size");
+		int level = 0;
+		std::string type;
+		std::string size;
+		if (!(level_file >> level) || !(type_file >> type) || !(size_file >> size))
+		{
+			break;
+		}
+		auto const bytes = parse_cache_size(size);
+		if (bytes == 0)
+		{
+			continue;
+		}
+		if (level == 1 && type == "Data")
+		{
+			cache_sizes.m_l1d = bytes;
+			found = true;
+		}
+		else if (level == 2 && type == "Unified")
+		{
+			cache_sizes.m_l2 = bytes;
+			found = true;
+		}
+	}
+#endif
+	return found;
+}
+
+bool get_cpuid_cache_sizes(Cache_sizes& cache_sizes)
+{
+	//deterministic cache parameters.  Intel has them in leaf 4, AMD in leaf 0x8000001d with the same layout.
+	for (std::uint32_t const leaf : { 0x4U, 0x8000001DU })
+	{
+		bool found = false;
+		std::uint32_t registers[4]{};
+		for (std::uint32_t subleaf = 0; subleaf < 16 && cpuid(leaf, subleaf, registers); subleaf++)
+		{
+			//0 = no more caches, 1 = data, 3 = unified
+			auto const type = registers[0] & 0x1F;
+			if (type == 0)
+			{
+				break;
+			}
+			auto const level = (registers[0] >> 5) & 0x7;
+			//ways * partitions * line size * sets
+			std::uint32_t const size = (((registers[1] >> 22) & 0x3FF) + 1) * (((registers[1] >> 12) & 0x3FF) + 1) *
+				((registers[1] & 0xFFF) + 1) * (registers[2] + 1);
+			if (level == 1 && type == 1)
+			{
+				cache_sizes.m_l1d = size;
+				found = true;
+			}
+			else if (level == 2 && type == 3)
+			{
+				cache_sizes.m_l2 = size;
+				found = true;
+			}
+		}
+		if (found)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+}
+
+Cache_sizes get_cache_sizes()
+{
+	Cache_sizes cache_sizes;
+	if (!get_sysfs_cache_sizes(cache_sizes))
+	{
+		get_cpuid_cache_sizes(cache_sizes);
+	}
+	return cache_sizes;
+}
+
+}
+}
@@ -0,0 +1,168 @@
+#include "cpu/hash_kernel.hpp"
+#include "LLC/hash/SK.h"
+#include "LLC/types/uint1024.h"
+#include <array>
+#include <chrono>
+#include <vector>
+
+namespace nexusminer
+{
+namespace cpu
+{
+
+namespace
+{
+constexpr std::size_t header_length = 216;
+constexpr std::size_t nonce_offset = 208;
+
+std::vector<unsigned char> test_header()
+{
+	//any header works.  The expected result is calculated with the reference hash.
+	std::vector<unsigned char> header(header_length);
+	for (std::size_t i = 0; i < header.size(); i++)
+	{
+		header[i] = static_cast<unsigned char>(i * 131 + 7);
+	}
+	return header;
+}
+}
+
+bool hash_kernel_self_test(HashKernel const& kernel)
+{
+	if (!kernel.supported)
+	{
+		return false;
+	}
+	auto header = test_header();
+	NexusSkein skein;
+	skein.setMessage(header);
+	std::array<std::uint64_t, NexusSkein::lanesAVX512> nonces;
+	std::array<std::uint64_t, NexusSkein::lanesAVX512> results;
+	for (int batch = 0; batch < 4; batch++)
+	{
+		for (int lane = 0; lane < kernel.lanes; lane++)
+		{
+			nonces[lane] = 0x0123456789ABCDEFULL * static_cast<std::uint64_t>(batch * kernel.lanes + lane + 1);
+		}
+		(skein.*kernel.calculateResult)(nonces.data(), results.data());
+		for (int lane = 0; lane < kernel.lanes; lane++)
+		{
+			//the nonce is the last 8 bytes of the header, little endian
+			for (std::size_t i = 0; i < 8; i++)
+			{
+				header[nonce_offset + i] = static_cast<unsigned char>(nonces[lane] >> (8 * i));
+			}
+			uint1024_t reference = LLC::SK1024(header.begin(), header.end());
+			//the kernel returns the most significant 64 bits of the hash
+			if (results[lane] != reference.Get64(15))
+			{
+				return false;
+			}
+		}
+	}
+
+	//the batch loop used for mining.  A threshold of all ones reports every nonce.
+	//the range does not end on a multiple of the lanes to check the last partial call.
+	std::uint64_t const first_nonce = 0xFEDCBA9876543210ULL;
+	std::uint64_t const count = 4 * kernel.lanes + 1;
+	std::vector<NexusSkein::Candidate> candidates;
+	(skein.*kernel.hashRange)(first_nonce, count, ~0ULL, candidates);
+	if (candidates.size() != count)
+	{
+		return false;
+	}
+	for (std::uint64_t i = 0; i < count; i++)
+	{
+		if (candidates[i].nonce != first_nonce + i)
+		{
+			return false;
+		}
+		for (std::size_t j = 0; j < 8; j++)
+		{
+			header[nonce_offset + j] = static_cast<unsigned char>(candidates[i].nonce >> (8 * j));
+		}
+		uint1024_t reference = LLC::SK1024(header.begin(), header.end());
+		if (candidates[i].result != reference.Get64(15))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+double measure_hash_kernel(HashKernel const& kernel)
+{
+	NexusSkein skein;
+	skein.setMessage(test_header());
+	//a threshold of 0 reports nothing.  Only the hashing is measured.
+	std::vector<NexusSkein::Candidate> candidates;
+	std::uint64_t const batch_size = 1024;
+	std::uint64_t hash_count = 0;
+	auto const start = std::chrono::steady_clock::now();
+	auto const duration = std::chrono::milliseconds(100);
+	auto elapsed = std::chrono::steady_clock::duration{};
+	do
+	{
+		(skein.*kernel.hashRange)(hash_count, batch_size, 0, candidates);
+		hash_count += batch_size;
+		elapsed = std::chrono::steady_clock::now() - start;
+	} while (elapsed < duration);
+	return hash_count / std::chrono::duration<double>(elapsed).count();
+}
+
+HashKernel const& select_hash_kernel(std::string const& name, spdlog::logger& logger, std::string const& log_leader)
+{
+	HashKernel const* selected = nullptr;
+	if (!name.empty())
+	{
+		auto const* kernel = findHashKernel(name);
+		if (!kernel)
+		{
+			logger.error(log_leader + "Unknown hash kernel {}. Selecting the kernel automatically.", name);
+		}
+		else if (!kernel->supported)
+		{
+			logger.error(log_leader + "Hash kernel {} is not supported by this CPU. Selecting the kernel automatically.", name);
+		}
+		else if (!hash_kernel_self_test(*kernel))
+		{
+			logger.error(log_leader + "Hash kernel {} failed the self test. Selecting the kernel automatically.", name);
+		}
+		else
+		{
+			selected = kernel;
+		}
+	}
+
+	//the kernels are ordered slowest to fastest
+	auto const& kernels = getHashKernels();
+	for (auto kernel = kernels.rbegin(); !selected && kernel != kernels.rend(); ++kernel)
+	{
+		if (!kernel->supported)
+		{
+			continue;
+		}
+		if (hash_kernel_self_test(*kernel))
+		{
+			selected = &(*kernel);
+		}
+		else
+		{
+			logger.error(log_leader + "Hash kernel {} failed the self test.", kernel->name);
+		}
+	}
+
+	if (!selected)
+	{
+		//only possible if the scalar hash is broken
+		logger.error(log_leader + "No hash kernel passed the self test.");
+		selected = &kernels.front();
+	}
+
+	logger.info(log_leader + "Using the {} hash kernel ({} nonces per call). Single thread rate {:.3f} MH/s.",
+		selected->name, selected->lanes, measure_hash_kernel(*selected) / 1.0e6);
+	return *selected;
+}
+
+}
+}
@@ -0,0 +1,89 @@
+#include "cpu/hash_verifier.hpp"
+#include "LLC/hash/SK.h"
+#include "LLC/types/uint1024.h"
+
+namespace nexusminer
+{
+namespace cpu
+{
+
+Hash_verifier::Hash_verifier(std::shared_ptr<spdlog::logger> logger, std::string log_leader)
+: m_logger{std::move(logger)}
+, m_log_leader{std::move(log_leader)}
+, m_stop{false}
+, m_error_count{0}
+, m_verified_count{0}
+, m_thread{&Hash_verifier::run, this}
+{
+}
+
+Hash_verifier::~Hash_verifier()
+{
+	{
+		std::scoped_lock<std::mutex> lck(m_mtx);
+		m_stop = true;
+	}
+	m_cv.notify_one();
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+}
+
+void Hash_verifier::submit(std::shared_ptr<Block_data::Header_bytes const> header, std::uint64_t nonce, std::uint64_t result)
+{
+	{
+		std::scoped_lock<std::mutex> lck(m_mtx);
+		if (m_samples.size() >= max_queued_samples)
+		{
+			//the verifier can't keep up.  Skip the sample rather than slow down hashing.
+			return;
+		}
+		m_samples.push_back(Sample{ std::move(header), nonce, result });
+	}
+	m_cv.notify_one();
+}
+
+void Hash_verifier::reset_statistics()
+{
+	m_error_count = 0;
+	m_verified_count = 0;
+}
+
+void Hash_verifier::run()
+{
+	Block_data::Header_bytes header;
+	while (true)
+	{
+		Sample sample;
+		{
+			std::unique_lock<std::mutex> lck(m_mtx);
+			m_cv.wait(lck, [this]() { return m_stop || !m_samples.empty(); });
+			if (m_stop)
+			{
+				return;
+			}
+			sample = std::move(m_samples.front());
+			m_samples.pop_front();
+		}
+
+		//the nonce is the last 8 bytes of the header, little endian
+		header = *sample.m_header;
+		auto const nonce_offset = header.size() - 8;
+		for (std::size_t i = 0; i < 8; i++)
+		{
+			header[nonce_offset + i] = static_cast<unsigned char>(sample.m_nonce >> (8 * i));
+		}
+		uint1024_t reference = LLC::SK1024(header.begin(), header.end());
+		++m_verified_count;
+		if (reference.Get64(15) != sample.m_result)
+		{
+			++m_error_count;
+			m_logger->error(m_log_leader + "Hash kernel error for nonce {}. Kernel {:016x} reference {:016x}.",
+				sample.m_nonce, sample.m_result, reference.Get64(15));
+		}
+	}
+}
+
+}
+}
@@ -1,16 +1,57 @@
 #include "chain_sieve.hpp"
 #include <primesieve.hpp>
 #include <vector>
-#include <queue>
+#include <algorithm>
+#include <cstring>
 #include <chrono>
 #include <bitset>
 #include <sstream>
 #include <boost/integer/mod_inverse.hpp>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace nexusminer {
     namespace cpu
     {
         using namespace boost::multiprecision;
+
+        namespace
+        {
+            //groups of the primes 7 to 61.  The pattern of a group is the product of its primes long.  All fit in L1 together.
+            std::vector<std::vector<uint32_t>> const presieve_groups{ {7, 11, 13, 17}, {19, 23, 29}, {31, 37}, {41, 43}, {47, 53}, {59, 61} };
+
+            constexpr uint64_t byte_lsbs = 0x0101010101010101ULL;
+
+            //the sieve bytes [n, n + 8) as a little endian word
+            uint64_t load_sieve_word(uint8_t const* sieve, uint64_t n)
+            {
+                uint64_t word;
+                std::memcpy(&word, sieve + n, sizeof(word));
+                return word;
+            }
+
+            //the popcount of every byte of the word in that byte
+            uint64_t byte_popcounts(uint64_t x)
+            {
+                x = x - ((x >> 1) & 0x5555555555555555ULL);
+                x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+                return (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+            }
+
+            //x must not be zero
+            int count_trailing_zeros(uint64_t x)
+            {
+#if defined(_MSC_VER)
+                unsigned long index;
+                _BitScanForward64(&index, x);
+                return static_cast<int>(index);
+#else
+                return __builtin_ctzll(x);
+#endif
+            }
+        }
+
         Chain::Chain()
         {
         }
@@ -179,10 +220,36 @@ namespace nexusminer {
             return ss.str();
         }
 
-        Sieve::Sieve()
+        Sieve::Sieve(Cache_sizes const& cache_sizes)
             : m_logger{ spdlog::get("logger") }
+            , m_block_size{ std::clamp(cache_sizes.m_l1d, min_sieve_block_size, max_sieve_size) }
+            //whole blocks that fit in L2
+            , m_sieve_size{ std::clamp(cache_sizes.m_l2 / m_block_size * m_block_size, m_block_size, max_sieve_size / m_block_size * m_block_size) }
+            , m_segment_size{ m_sieve_size * 30 }
         {
-            m_sieve.resize(sieve_size);
+            m_sieve.resize(m_sieve_size);
+            for (auto const& group : presieve_groups)
+            {
+                uint32_t period = 1;
+                for (auto p : group)
+                    period *= p;
+                //byte i covers the integers 30 * i + sieve30_offsets[bit]
+                std::vector<uint8_t> pattern(period, sieve30);
+                for (uint32_t i = 0; i < period; i++)
+                {
+                    for (int bit = 0; bit < 8; bit++)
+                    {
+                        uint64_t const n = 30ULL * i + sieve30_offsets[bit];
+                        for (auto p : group)
+                        {
+                            if (n % p == 0)
+                                pattern[i] &= ~(1 << bit);
+                        }
+                    }
+                }
+                m_presieve_patterns.push_back(std::move(pattern));
+            }
+            m_presieve_offsets.resize(m_presieve_patterns.size(), 0);
             reset_stats();
 			reset_sieve_batch(0);
         }
@@ -192,14 +259,21 @@ namespace nexusminer {
             //generate sieving primes
             m_logger->info("Generating sieving primes up to {}...", sieving_prime_limit);
             auto start = std::chrono::steady_clock::now();
-            primesieve::generate_primes(sieving_start_prime, sieving_prime_limit, &m_sieving_primes);
+            std::vector<uint32_t> sieving_primes;
+            primesieve::generate_primes(sieving_start_prime, sieving_prime_limit, &sieving_primes);
+            m_sieving_primes = std::make_shared<std::vector<uint32_t> const>(std::move(sieving_primes));
             auto end = std::chrono::steady_clock::now();
             auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
             std::stringstream ss;
-            ss << "Done. " << m_sieving_primes.size() << " primes generated in " << std::fixed << std::setprecision(3) << elapsed.count() / 1000.0 << " seconds.";
+            ss << "Done. " << m_sieving_primes->size() << " primes generated in " << std::fixed << std::setprecision(3) << elapsed.count() / 1000.0 << " seconds.";
             m_logger->info(ss.str());
         }
 
+        void Sieve::share_sieving_primes(Sieve const& other)
+        {
+            m_sieving_primes = other.m_sieving_primes;
+        }
+
         void Sieve::set_sieve_start(boost::multiprecision::uint1024_t sieve_start)
         {
             //set the sieve start to a multiple of 30
@@ -208,6 +282,8 @@ namespace nexusminer {
                 sieve_start += 30 - (sieve_start % 30);
             }
             m_sieve_start = sieve_start;
+            //an open chain belongs to the old start
+            m_chain_in_process = false;
         }
 
         boost::multiprecision::uint1024_t Sieve::get_sieve_start()
@@ -218,17 +294,46 @@ namespace nexusminer {
         void Sieve::calculate_starting_multiples()
         {
             //generate starting multiples of the sieving primes
+            auto const& sieving_primes = *m_sieving_primes;
+            //the segment starts at the byte m_sieve_start / 30 of each pattern
+            boost::multiprecision::uint1024_t const start_byte = m_sieve_start / 30;
+            for (std::size_t i = 0; i < m_presieve_patterns.size(); i++)
+            {
+                m_presieve_offsets[i] = static_cast<std::size_t>(start_byte % m_presieve_patterns[i].size());
+            }
+            m_presieve_prime_count = std::upper_bound(sieving_primes.begin(), sieving_primes.end(), max_presieve_prime) - sieving_primes.begin();
+            //at least two multiples per block.  A block covers 30 * m_block_size integers, 8 of 30 of them are multiples on the wheel.
+            m_l1_prime_end = std::max(m_presieve_prime_count,
+                static_cast<std::size_t>(std::upper_bound(sieving_primes.begin(), sieving_primes.end(), 4 * m_block_size) - sieving_primes.begin()));
+            m_large_prime_start = std::lower_bound(sieving_primes.begin(), sieving_primes.end(), (m_segment_size + 1) / 2) - sieving_primes.begin();
             m_multiples = {};
             m_wheel_indices = {};
-            m_logger->info("Calculating starting multiples.");
+            m_multiples.reserve(m_large_prime_start);
+            m_wheel_indices.reserve(m_large_prime_start);
+            //the first multiple is less than 8 primes away and the largest step is 6 primes
+            clear_buckets();
+            if (!sieving_primes.empty())
+            {
+                m_segment_buckets.assign(8 * static_cast<uint64_t>(sieving_primes.back()) / m_segment_size + 2, nullptr);
+            }
+            m_logger->debug("Calculating starting multiples.");
             auto start = std::chrono::steady_clock::now();
-            for (auto s : m_sieving_primes)
+            for (std::size_t i = 0; i < sieving_primes.size(); i++)
             {
+                auto const s = sieving_primes[i];
                 uint32_t m = get_offset_to_next_multiple(m_sieve_start, s);
-                m_multiples.push_back(m);
                 //where is the starting multiple relative to the wheel
-                int wheel_index = (boost::integer::mod_inverse((int)s, 30) * m) % 30;
-                m_wheel_indices.push_back(sieve30_index[wheel_index]);
+                //reduced first.  inverse * m overflows 32 bits for the large primes.
+                int wheel_index = (boost::integer::mod_inverse((int)s, 30) * (m % 30)) % 30;
+                if (i < m_large_prime_start)
+                {
+                    m_multiples.push_back(m);
+                    m_wheel_indices.push_back(sieve30_index[wheel_index]);
+                }
+                else
+                {
+                    push_bucket(m / m_segment_size, s, m % m_segment_size, sieve30_index[wheel_index]);
+                }
             }
             auto end = std::chrono::steady_clock::now();
             auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
@@ -239,14 +344,28 @@ namespace nexusminer {
 
         void Sieve::sieve_segment()
         {
-            for (std::size_t i = 0; i < m_sieving_primes.size(); i++)
+            for (std::size_t block = 0; block < m_sieve.size(); block += m_block_size)
+            {
+                std::size_t const block_end = std::min<std::size_t>(block + m_block_size, m_sieve.size());
+                bool const last_block = block_end == m_sieve.size();
+                presieve(block, block_end);
+                cross_off(m_presieve_prime_count, m_l1_prime_end, static_cast<uint32_t>(block_end * 30), last_block ? m_segment_size : 0);
+            }
+            cross_off(m_l1_prime_end, m_large_prime_start, m_segment_size, m_segment_size);
+            sieve_large_primes();
+        }
+
+        void Sieve::cross_off(std::size_t first, std::size_t last, uint32_t limit, uint32_t rebase)
+        {
+            auto const& sieving_primes = *m_sieving_primes;
+            for (std::size_t i = first; i < last; i++)
             {
                 uint32_t j = m_multiples[i];
-                uint32_t k = m_sieving_primes[i];
+                uint32_t k = sieving_primes[i];
                 //where are we in the wheel
                 int wheel_index = m_wheel_indices[i];
                 int next_wheel_gap = sieve30_gaps[wheel_index];
-                while (j < m_segment_size)
+                while (j < limit)
                 {
                     m_sieve[j / 30] &= unset_bit_mask[j % 30];
                     //increment the next multiple of the current prime (rotate the wheel).
@@ -254,11 +373,111 @@ namespace nexusminer {
                     wheel_index = (wheel_index + 1) % 8;
                     next_wheel_gap = sieve30_gaps[wheel_index];
                 }
-                //save the starting multiple and wheel index for the next segment
-                m_multiples[i] = j - m_segment_size;
+                //save the starting multiple and wheel index for the next block or segment
+                m_multiples[i] = j - rebase;
                 m_wheel_indices[i] = wheel_index;
             }
         }
+
+        //fill the block with the small prime patterns.  The first pattern is copied and the others are and-ed on top
+        //while the block is in L1.
+        void Sieve::presieve(std::size_t block, std::size_t block_end)
+        {
+            for (std::size_t i = 0; i < m_presieve_patterns.size(); i++)
+            {
+                auto const& pattern = m_presieve_patterns[i];
+                auto& position = m_presieve_offsets[i];
+                for (std::size_t n = block; n < block_end;)
+                {
+                    std::size_t const run = std::min(pattern.size() - position, block_end - n);
+                    uint8_t const* source = pattern.data() + position;
+                    uint8_t* target = m_sieve.data() + n;
+                    if (i == 0)
+                    {
+                        std::copy(source, source + run, target);
+                    }
+                    else
+                    {
+                        for (std::size_t j = 0; j < run; j++)
+                            target[j] &= source[j];
+                    }
+                    n += run;
+                    position += run;
+                    if (position == pattern.size())
+                        position = 0;
+                }
+            }
+        }
+
+        //cross off the multiples of the large primes in the bucket list of this segment and move each prime to the
+        //bucket list of the segment of its next multiple
+        void Sieve::sieve_large_primes()
+        {
+            if (m_segment_buckets.empty())
+                return;
+            auto const current = m_current_segment_bucket;
+            Bucket* bucket = m_segment_buckets[current];
+            m_segment_buckets[current] = nullptr;
+            while (bucket != nullptr)
+            {
+                for (uint32_t i = 0; i < bucket->m_size; i++)
+                {
+                    auto const& entry = bucket->m_entries[i];
+                    uint32_t const k = entry.m_prime;
+                    uint32_t const sieve_byte = entry.m_byte_and_wheel >> 3;
+                    int const wheel_index = entry.m_byte_and_wheel & 7;
+                    //the multiple is k * q with q at the wheel index
+                    int const multiple_mod_30 = (k % 30) * sieve30_offsets[wheel_index] % 30;
+                    m_sieve[sieve_byte] &= unset_bit_mask[multiple_mod_30];
+                    uint64_t const next_multiple = 30ULL * sieve_byte + multiple_mod_30 + static_cast<uint64_t>(k) * sieve30_gaps[wheel_index];
+                    push_bucket(next_multiple / m_segment_size, k, next_multiple % m_segment_size, (wheel_index + 1) % 8);
+                }
+                //processed.  back to the free list.
+                Bucket* next = bucket->m_next;
+                bucket->m_next = m_free_buckets;
+                m_free_buckets = bucket;
+                bucket = next;
+            }
+            m_current_segment_bucket = (current + 1) % m_segment_buckets.size();
+        }
+
+        void Sieve::push_bucket(std::size_t segments_ahead, uint32_t prime, uint64_t multiple, int wheel_index)
+        {
+            Bucket*& head = m_segment_buckets[(m_current_segment_bucket + segments_ahead) % m_segment_buckets.size()];
+            if (head == nullptr || head->m_size == bucket_size)
+            {
+                Bucket* bucket = m_free_buckets;
+                if (bucket != nullptr)
+                {
+                    m_free_buckets = bucket->m_next;
+                }
+                else
+                {
+                    m_bucket_storage.push_back(std::make_unique<Bucket>());
+                    bucket = m_bucket_storage.back().get();
+                }
+                bucket->m_next = head;
+                bucket->m_size = 0;
+                head = bucket;
+            }
+            head->m_entries[head->m_size++] = { prime, static_cast<uint32_t>(multiple / 30) << 3 | static_cast<uint32_t>(wheel_index) };
+        }
+
+        void Sieve::clear_buckets()
+        {
+            //the buckets are kept for the next start
+            for (auto& head : m_segment_buckets)
+            {
+                while (head != nullptr)
+                {
+                    Bucket* next = head->m_next;
+                    head->m_next = m_free_buckets;
+                    m_free_buckets = head;
+                    head = next;
+                }
+            }
+            m_current_segment_bucket = 0;
+        }
 		
 		//batch sieve on the cpu for debug
         void Sieve::sieve_batch_cpu(uint64_t low)
@@ -280,8 +499,7 @@ namespace nexusminer {
 
         void Sieve::reset_sieve()
         {
-            //fill the sieve with default values (all ones)
-            std::fill(m_sieve.begin(), m_sieve.end(), sieve30);
+            //sieve_segment fills the sieve with the pre-sieve patterns
             //m_fermat_candidates = {};
             m_long_chain_starts = {};
         }
@@ -299,7 +517,10 @@ namespace nexusminer {
 
         void Sieve::reset_stats()
         {
-            m_chain_histogram = std::vector<std::uint32_t>(10, 0);
+            for (auto& count : m_chain_histogram)
+            {
+                count = 0;
+            }
             m_fermat_test_count = 0;
             m_fermat_prime_count = 0;
             m_chain_count = 0;
@@ -308,38 +529,59 @@ namespace nexusminer {
         }
 
         //search the sieve for chains that meet the minimum length requirement.  Chains can cross segment boundaries.
-        void Sieve::find_chains(uint64_t low, bool batch_sieve_mode)
+        void Sieve::find_chains(uint64_t low, bool batch_sieve_mode, uint64_t first_byte)
         {
             std::vector<uint8_t>& sieve = batch_sieve_mode?m_sieve_results:m_sieve;
-            uint64_t sieve_size = sieve.size();
+            scan_chains(sieve.data(), sieve.size(), first_byte, low);
+        }
 
-            //get popcount of the first three bytes  
-            int hits_next_four_bytes = 0;
-            std::queue<int> pop_count;
-            pop_count.push(0);
-            for (int i = 0; i < 3; i++)
+        std::vector<uint8_t> Sieve::get_chain_handoff()
+        {
+            auto boundary = std::find(m_sieve.begin(), m_sieve.end(), 0);
+            if (boundary != m_sieve.end())
             {
-                int pop_count_this_byte = popcnt[sieve[i]];
-                pop_count.push(pop_count_this_byte);
-                hits_next_four_bytes += pop_count_this_byte;
+                //the empty byte closes the chain
+                ++boundary;
             }
-            for (uint64_t n = 0; n < sieve_size; n++)
+            return { m_sieve.begin(), boundary };
+        }
+
+        void Sieve::finish_chains(std::vector<uint8_t> const& handoff, uint64_t low)
+        {
+            scan_chains(handoff.data(), handoff.size(), 0, low);
+            if (m_chain_in_process)
+                close_chain();
+        }
+
+        //low is the offset of sieve[0]
+        void Sieve::scan_chains(uint8_t const* sieve, uint64_t sieve_size, uint64_t first_byte, uint64_t low)
+        {
+            //a window of four bytes (120 integers) holds at most 32 candidates so the window counts fit in a byte
+            static_assert(m_min_chain_length > 0 && m_min_chain_length <= 32);
+            constexpr uint64_t dense_bias = (0x80 - m_min_chain_length) * byte_lsbs;
+            //the first five bytes of a word start a window that lies within the word
+            constexpr uint64_t window_starts = 0x8080808080ULL;
+            uint64_t n = first_byte;
+            while (n < sieve_size)
             {
-                //remove the oldest popcount from the running sum.
-                hits_next_four_bytes -= pop_count.front();
-                pop_count.pop();
-                //get popcount of the current byte
-                if (n + 3 < sieve_size)
+                //a window running past the end misses the candidates of the next segment.  The last bytes are scanned one by one
+                //so a chain starting there stays open.
+                if (!m_chain_in_process && n + 8 <= sieve_size)
                 {
-                    pop_count.push(popcnt[sieve[n + 3]]);
-                    hits_next_four_bytes += pop_count.back(); 
-                }
-                if (!m_chain_in_process && hits_next_four_bytes < m_min_chain_length)
-                {
-                    //not enough prime candidates in the next 120 numbers to make a long enough chain
-
+                    //skip to the next byte starting a window with enough prime candidates to make a long enough chain
+                    uint64_t const counts = byte_popcounts(load_sieve_word(sieve, n));
+                    //byte i holds the candidate count of the bytes [n + i, n + i + 4)
+                    uint64_t const windows = counts + (counts >> 8) + (counts >> 16) + (counts >> 24);
+                    //the top bit of a byte is set where the count is at least m_min_chain_length
+                    uint64_t const dense = (windows + dense_bias) & window_starts;
+                    if (dense == 0)
+                    {
+                        n += 5;
+                        continue;
+                    }
+                    n += count_trailing_zeros(dense) / 8;
                 }
-                else if (sieve[n] == 0)
+                if (sieve[n] == 0)
                 {
                     //no primes in this group of 30.  end the current chain if it is open.
                     if (m_chain_in_process)
@@ -347,13 +589,11 @@ namespace nexusminer {
                 }
                 else
                 {
-                    int index_of_highest_set_bit = 0;
                     int sieve_offset = 0;
                     int previous_sieve_offset = 0;
                     for (uint8_t b = sieve[n]; b > 0; b &= b - 1)
                     {
-                        int index_of_lowest_set_bit = boost::multiprecision::lsb(b);//c++20 alternative to lsb(b) is std::countr_zero(b);
-                        sieve_offset = sieve30_offsets[index_of_lowest_set_bit];
+                        sieve_offset = sieve30_offsets[count_trailing_zeros(b)];
                         uint64_t prime_candidate_offset = low + n * 30 + sieve_offset;
                         if (m_chain_in_process)
                         {
@@ -375,7 +615,6 @@ namespace nexusminer {
                             //start a new chain
                             open_chain(prime_candidate_offset);
                         }
-                        index_of_highest_set_bit = index_of_lowest_set_bit;
                         previous_sieve_offset = sieve_offset;
                     }
                     if (m_chain_in_process)
@@ -389,7 +628,7 @@ namespace nexusminer {
                         }
                     }
                 }
-               
+                n++;
             }
         }
 
@@ -444,7 +683,7 @@ namespace nexusminer {
                     m_chain[i].get_best_fermat_chain(base_offset, offset, length);
                     
                     //collect stats
-                    int count = std::min(static_cast<size_t>(length), m_chain_histogram.size());
+                    int count = std::min(static_cast<size_t>(length), m_chain_histogram.size() - 1);
                     m_chain_histogram[count]++;
                     
                     if (length >= m_chain[i].m_min_chain_report_length)
@@ -509,7 +748,7 @@ namespace nexusminer {
                     if (length > 0)
                     {
                         //collect stats
-                        int count = std::min(static_cast<size_t>(length), m_chain_histogram.size());
+                        int count = std::min(static_cast<size_t>(length), m_chain_histogram.size() - 1);
                         m_chain_histogram[count]++;
                     }
                     if (length >= chain.m_min_chain_report_length)
@@ -2,11 +2,14 @@
 #define CHAIN_SIEVE_HPP
 
 #include <vector>
+#include <array>
 #include <atomic>
+#include <memory>
 #include <spdlog/spdlog.h>
 #include <boost/multiprecision/cpp_int.hpp>
 #include <boost/multiprecision/gmp.hpp>
 #include "sieve_utils.hpp"
+#include "cpu/cache_sizes.hpp"
 
 namespace nexusminer {
 	namespace cpu
@@ -66,8 +69,11 @@ namespace nexusminer {
 		class Sieve
 		{
 		public:
-			Sieve();
+			//the segment and block sizes follow the caches of the cpu the sieve runs on
+			explicit Sieve(Cache_sizes const& cache_sizes);
 			void generate_sieving_primes();
+			//use the sieving primes of another sieve.  The table is read only once generated so the sieves of all threads share it.
+			void share_sieving_primes(Sieve const& other);
 			void set_sieve_start(boost::multiprecision::uint1024_t);
 			boost::multiprecision::uint1024_t get_sieve_start();
 			void calculate_starting_multiples();
@@ -80,7 +86,15 @@ namespace nexusminer {
 			void reset_sieve_batch(uint64_t low);
 			void clear_chains();
 			void reset_stats();
-			void find_chains(uint64_t low, bool batch_sieve_mode);
+			//search the sieve from first_byte on.  The bytes before it are handled by the thread of the previous chunk.
+			void find_chains(uint64_t low, bool batch_sieve_mode, uint64_t first_byte = 0);
+			//the first bytes of the segment up to and including the first one without candidates.  No chain crosses that byte.
+			//The thread sieving the previous chunk finishes its chains with them.  find_chains skips them here.
+			//A segment without an empty byte is handed off whole.  A chain running on into the next segment is then cut there.
+			std::vector<uint8_t> get_chain_handoff();
+			//continue the chains at the end of the chunk into the handoff of the next chunk (at offset low) and close them.
+			//An empty handoff just closes the open chain.
+			void finish_chains(std::vector<uint8_t> const& handoff, uint64_t low);
 			uint64_t count_fermat_primes(uint64_t sieve_size, uint64_t low);
 			bool primality_test(boost::multiprecision::uint1024_t p);
 			void test_chains();
@@ -88,18 +102,21 @@ namespace nexusminer {
 			void primality_batch_test_cpu();
 			void clean_chains();
 			uint64_t get_current_chain_list_length();
+			//the sieve bytes of the last segment and the chains found since clear_chains()
+			std::vector<uint8_t> const& get_sieve() const { return m_sieve; }
+			std::vector<Chain> const& get_chains() const { return m_chain; }
 			int get_fermat_test_batch_size() { return m_fermat_test_batch_size; }
 			std::vector<std::uint64_t> m_long_chain_starts;
 			uint64_t m_sieve_batch_start_offset;
 
-			//stats
-			std::vector<std::uint32_t> m_chain_histogram;
-			uint64_t m_fermat_test_count = 0;
-			uint64_t m_fermat_prime_count = 0;
-			uint64_t m_chain_count = 0;
+			//stats.  Written by the mining thread, summed up by update_statistics on the io thread.
+			std::array<std::atomic<std::uint32_t>, 10> m_chain_histogram{};
+			std::atomic<uint64_t> m_fermat_test_count{0};
+			std::atomic<uint64_t> m_fermat_prime_count{0};
+			std::atomic<uint64_t> m_chain_count{0};
 			int m_chain_candidate_max_length = 0;
 			uint64_t m_chain_candidate_total_length = 0;
-			double m_best_chain = 0;
+			std::atomic<double> m_best_chain{0};
 
 		private:
 			class Fermat_test_candidate {
@@ -116,20 +133,28 @@ namespace nexusminer {
 			static constexpr int sieve30_offsets[]{ 1,7,11,13,17,19,23,29 };  // each bit in the sieve30 represets an offset from the base mod 30
 			static constexpr int sieve30_gaps[]{ 6,4,2,4,2,4,6,2 };
 			static constexpr int sieve30_index[]{ -1,0,-1,-1,-1,-1,-1, 1, -1, -1, -1, 2, -1, 3, -1, -1, -1, 4, -1, 5, -1, -1, -1, 6, -1, -1, -1, -1, -1, 7 };  //reverse lookup table (offset mod 30 to index)
-			static constexpr int L1_CACHE_SIZE = 32768;
-			static constexpr int L2_CACHE_SIZE = 262144;
 			//upper limit of the sieving range
 			//static constexpr uint64_t sieve_range = 3e9;//3e9;
 			//upper limit of the sieving primes. 
 			static constexpr uint32_t sieving_prime_limit = 3e8; //3e8;
-			static constexpr uint32_t sieve_size = L2_CACHE_SIZE * 16;
-			//each segment byte covers a range of 30 sieving primes 
-			static constexpr uint32_t m_segment_size = sieve_size * 30;
+			//limits of the sieve size in bytes.  The bucket entries address up to 2^29 bytes.
+			static constexpr uint32_t min_sieve_block_size = 4096;
+			static constexpr uint32_t max_sieve_size = 16 * 1024 * 1024;
 			//number of segments needed to cover the sieving range
 			//static constexpr int segments = sieve_range / m_segment_size + (sieve_range % m_segment_size != 0);
 			//we start sieving at 7
 			static constexpr int sieving_start_prime = 7;
 			static constexpr int m_min_chain_length = 8;
+			//The segment fits in L2 and is sieved in L1 sized blocks.  The pre-sieve and the primes hitting every block at
+			//least twice (m_l1_prime_end) run block by block.  The other medium primes run once per segment.
+			uint32_t m_block_size;
+			uint32_t m_sieve_size;
+			//each segment byte covers a range of 30 sieving primes 
+			uint32_t m_segment_size;
+			//the sieving primes up to this one are crossed off by copying precomputed patterns over the segment
+			static constexpr uint32_t max_presieve_prime = 61;
+			//large sieving primes wait in buckets for the segment of their next multiple
+			static constexpr std::size_t bucket_size = 1024;
 
 			/// Bitmasks used to unset bits
 			static constexpr uint8_t unset_bit_mask[30] =
@@ -144,32 +169,37 @@ namespace nexusminer {
 				(uint8_t)~(1 << 7), (uint8_t)~(1 << 7), (uint8_t)~(1 << 7), (uint8_t)~(1 << 7), (uint8_t)~(1 << 7), (uint8_t)~(1 << 7)
 			};
 
-			//how many bits are set in a byte
-			static constexpr int popcnt[256] =
-			{
-			  0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
-			  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-			  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-			  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-			  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-			  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-			  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-			  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-			  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-			  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-			  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-			  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-			  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-			  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-			  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-			  4, 5, 5, 6, 5, 6, 6, 7, 5, 6, 6, 7, 6, 7, 7, 8
-			};
-
 			//the sieve.  each bit that is set represents a possible prime.
 			std::vector<uint8_t> m_sieve;
-			std::vector<uint32_t> m_sieving_primes;
+			std::shared_ptr<std::vector<uint32_t> const> m_sieving_primes;
 			std::vector<uint32_t> m_multiples;
-			std::vector<int> m_wheel_indices;
+			std::vector<uint8_t> m_wheel_indices;
+			//A large sieving prime steps over a whole segment with the smallest wheel gap (2 * p >= m_segment_size) so it hits
+			//a segment at most once.  Instead of being visited in every segment it waits in the bucket list of the segment of
+			//its next multiple (like primesieve's EratBig).  Medium primes keep their entry in m_multiples.
+			struct Bucket_entry
+			{
+				uint32_t m_prime;
+				uint32_t m_byte_and_wheel;  //sieve byte of the multiple << 3 | wheel index
+			};
+			struct Bucket
+			{
+				Bucket* m_next = nullptr;
+				uint32_t m_size = 0;
+				std::array<Bucket_entry, bucket_size> m_entries;
+			};
+			//Pre-sieve.  A group of small primes clears the same bits every product-of-the-group bytes.  Each pattern holds
+			//one period of its group.  The offsets are the positions in the patterns of the next segment.
+			std::vector<std::vector<uint8_t>> m_presieve_patterns;
+			std::vector<std::size_t> m_presieve_offsets;
+			std::size_t m_presieve_prime_count = 0;  //index of the first sieving prime not covered by the patterns
+			std::size_t m_l1_prime_end = 0;  //index of the first medium prime sieved once per segment
+			std::size_t m_large_prime_start = 0;  //index of the first large sieving prime
+			//one bucket list per segment ahead.  m_segment_buckets[m_current_segment_bucket] holds the primes hitting the next segment.
+			std::vector<Bucket*> m_segment_buckets;
+			std::size_t m_current_segment_bucket = 0;
+			std::vector<std::unique_ptr<Bucket>> m_bucket_storage;
+			Bucket* m_free_buckets = nullptr;
 			std::vector<Chain> m_chain;
 			std::vector<uint8_t> m_sieve_results;  //accumulated results of sieving
 			boost::multiprecision::uint1024_t m_sieve_start;  //starting integer for the sieve.  This must be a multiple of 30.
@@ -177,7 +207,13 @@ namespace nexusminer {
 			Chain m_current_chain;
 			static constexpr int m_fermat_test_batch_size = 100;
 			static constexpr int m_segment_batch_size = 1; //number of segments to batch process
-			static constexpr int m_sieve_batch_buffer_size = sieve_size * m_segment_batch_size;
+			void presieve(std::size_t block, std::size_t block_end);
+			//cross off the multiples of the sieving primes [first, last) below limit.  The multiples are saved minus rebase.
+			void cross_off(std::size_t first, std::size_t last, uint32_t limit, uint32_t rebase);
+			void sieve_large_primes();
+			void push_bucket(std::size_t segments_ahead, uint32_t prime, uint64_t multiple, int wheel_index);
+			void clear_buckets();
+			void scan_chains(uint8_t const* sieve, uint64_t sieve_size, uint64_t first_byte, uint64_t low);
 			void close_chain();
 			void open_chain(uint64_t base_offset);
 		};
@@ -0,0 +1,238 @@
+#include "cpu/thread_affinity.hpp"
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace nexusminer
+{
+namespace cpu
+{
+
+namespace
+{
+//parse a kernel cpu list like "0-3,8,10-11"
+std::vector<std::uint16_t> parse_cpu_list(std::string const& cpu_list)
+{
+	std::vector<std::uint16_t> cpus;
+	std::stringstream ss(cpu_list);
+	std::string range;
+	while (std::getline(ss, range, ','))
+	{
+		auto const dash = range.find('-');
+		try
+		{
+			auto const first = std::stoul(range.substr(0, dash));
+			auto const last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+			for (auto cpu = first; cpu <= last; cpu++)
+			{
+				cpus.push_back(static_cast<std::uint16_t>(cpu));
+			}
+		}
+		catch (std::exception const&)
+		{
+			//trailing newline or garbage
+		}
+	}
+	return cpus;
+}
+
+std::vector<std::uint16_t> sorted_unique(std::vector<std::uint16_t> cpus)
+{
+	std::sort(cpus.begin(), cpus.end());
+	cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+	return cpus;
+}
+}
+
+std::string Thread_placement::to_string() const
+{
+	if (m_cpus.empty())
+	{
+		return {};
+	}
+	std::string placement = "cpus " + format_cpu_list(m_cpus);
+	if (m_numa_node >= 0)
+	{
+		placement += " numa node " + std::to_string(m_numa_node);
+	}
+	return placement;
+}
+
+Thread_placement get_thread_placement(config::Worker_config_cpu const& config, spdlog::logger& logger, std::string const& log_leader)
+{
+	Thread_placement placement;
+	auto cpus = sorted_unique(config.m_cpu_set);
+	if (config.m_numa_node >= 0)
+	{
+		auto const node_cpus = get_numa_node_cpus(config.m_numa_node);
+		if (node_cpus.empty())
+		{
+			logger.warn(log_leader + "No cpus found for numa node {}. Ignoring numa_node.", config.m_numa_node);
+		}
+		else if (cpus.empty())
+		{
+			cpus = node_cpus;
+			placement.m_numa_node = config.m_numa_node;
+		}
+		else
+		{
+			//only the cpus of the set on the requested node
+			std::vector<std::uint16_t> node_set_cpus;
+			std::set_intersection(cpus.begin(), cpus.end(), node_cpus.begin(), node_cpus.end(), std::back_inserter(node_set_cpus));
+			if (node_set_cpus.empty())
+			{
+				logger.warn(log_leader + "None of the cpus in cpu_set are on numa node {}. Ignoring numa_node.", config.m_numa_node);
+			}
+			else
+			{
+				cpus = node_set_cpus;
+				placement.m_numa_node = config.m_numa_node;
+			}
+		}
+	}
+
+	//drop cpus the process can't run on. Pinning to them fails.
+	auto const available_cpus = get_available_cpus();
+	std::vector<std::uint16_t> usable_cpus;
+	std::set_intersection(cpus.begin(), cpus.end(), available_cpus.begin(), available_cpus.end(), std::back_inserter(usable_cpus));
+	if (usable_cpus.size() != cpus.size())
+	{
+		logger.warn(log_leader + "Ignoring cpus not available to the miner. Requested {} available {}", format_cpu_list(cpus), format_cpu_list(available_cpus));
+	}
+	placement.m_cpus = std::move(usable_cpus);
+	if (placement.m_cpus.empty())
+	{
+		placement.m_numa_node = -1;
+	}
+	return placement;
+}
+
+std::vector<std::uint16_t> get_io_thread_cpus(std::vector<config::Worker_config> const& worker_config, spdlog::logger& logger)
+{
+	auto const is_cpu_worker = [](config::Worker_config const& worker) { return worker.m_mode == config::Worker_mode::CPU; };
+	bool const isolate_io_thread = std::any_of(worker_config.begin(), worker_config.end(), [&is_cpu_worker](auto const& worker)
+	{
+		return is_cpu_worker(worker) && std::get<config::Worker_config_cpu>(worker.m_worker_mode).m_isolate_io_thread;
+	});
+	if (!isolate_io_thread)
+	{
+		return {};
+	}
+	//the io thread stays off the cpus of every pinned cpu worker
+	std::vector<std::uint16_t> worker_cpus;
+	for (auto const& worker : worker_config)
+	{
+		if (is_cpu_worker(worker))
+		{
+			auto const placement = get_thread_placement(std::get<config::Worker_config_cpu>(worker.m_worker_mode), logger, "CPU Worker " + worker.m_id + ": ");
+			worker_cpus.insert(worker_cpus.end(), placement.m_cpus.begin(), placement.m_cpus.end());
+		}
+	}
+	worker_cpus = sorted_unique(std::move(worker_cpus));
+	auto const available_cpus = get_available_cpus();
+	std::vector<std::uint16_t> io_cpus;
+	std::set_difference(available_cpus.begin(), available_cpus.end(), worker_cpus.begin(), worker_cpus.end(), std::back_inserter(io_cpus));
+	if (io_cpus.empty())
+	{
+		logger.warn("isolate_io_thread: the cpu workers use every cpu. Set cpu_set or numa_node to leave a cpu for the io thread.");
+	}
+	return io_cpus;
+}
+
+bool set_thread_affinity(std::vector<std::uint16_t> const& cpus)
+{
+#if defined(__linux__)
+	if (cpus.empty())
+	{
+		return false;
+	}
+	cpu_set_t cpu_set;
+	CPU_ZERO(&cpu_set);
+	for (auto const cpu : cpus)
+	{
+		if (cpu < CPU_SETSIZE)
+		{
+			CPU_SET(cpu, &cpu_set);
+		}
+	}
+	return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#else
+	return false;
+#endif
+}
+
+std::vector<std::uint16_t> get_numa_node_cpus(int numa_node)
+{
+#if defined(__linux__)
+	//sysfs lists the cpus of every node.  No libnuma needed.
+	std::ifstream cpu_list_file("/sys/devices/system/node/node" + std::to_string(numa_node) + "/cpulist");
+	std::string cpu_list;
+	if (numa_node >= 0 && std::getline(cpu_list_file, cpu_list))
+	{
+		return sorted_unique(parse_cpu_list(cpu_list));
+	}
+#endif
+	return {};
+}
+
+std::vector<std::uint16_t> get_available_cpus()
+{
+	std::vector<std::uint16_t> cpus;
+#if defined(__linux__)
+	cpu_set_t cpu_set;
+	CPU_ZERO(&cpu_set);
+	if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0)
+	{
+		for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+		{
+			if (CPU_ISSET(cpu, &cpu_set))
+			{
+				cpus.push_back(static_cast<std::uint16_t>(cpu));
+			}
+		}
+		return cpus;
+	}
+#endif
+	auto const cpu_count = std::max(1U, std::thread::hardware_concurrency());
+	for (unsigned cpu = 0; cpu < cpu_count; cpu++)
+	{
+		cpus.push_back(static_cast<std::uint16_t>(cpu));
+	}
+	return cpus;
+}
+
+std::string format_cpu_list(std::vector<std::uint16_t> const& cpus)
+{
+	auto const sorted_cpus = sorted_unique(cpus);
+	std::string cpu_list;
+	for (std::size_t i = 0; i < sorted_cpus.size(); )
+	{
+		//collapse runs of consecutive cpus to first-last
+		std::size_t j = i;
+		while (j + 1 < sorted_cpus.size() && sorted_cpus[j + 1] == sorted_cpus[j] + 1)
+		{
+			j++;
+		}
+		if (!cpu_list.empty())
+		{
+			cpu_list += ",";
+		}
+		cpu_list += std::to_string(sorted_cpus[i]);
+		if (j != i)
+		{
+			cpu_list += "-" + std::to_string(sorted_cpus[j]);
+		}
+		i = j + 1;
+	}
+	return cpu_list;
+}
+
+}
+}
@@ -3,6 +3,10 @@
 #include "stats/stats_collector.hpp"
 #include "block.hpp"
 #include "hash/nexus_hash_utils.hpp"
+#include "cpu/hash_kernel.hpp"
+#include "cpu/thread_affinity.hpp"
+#include <algorithm>
+#include <vector>
 #include <asio.hpp>
 
 namespace nexusminer
@@ -10,157 +14,266 @@ namespace nexusminer
 namespace cpu
 {
 
-Worker_hash::Worker_hash(std::shared_ptr<asio::io_context> io_context, Worker_config& config) 
+namespace
+{
+std::uint16_t get_thread_count(config::Worker_config const& config, Thread_placement const& placement)
+{
+	auto const& worker_config_cpu = std::get<config::Worker_config_cpu>(config.m_worker_mode);
+	if (worker_config_cpu.m_threads != 0)
+	{
+		return worker_config_cpu.m_threads;
+	}
+	//one thread per pinned cpu
+	if (!placement.m_cpus.empty())
+	{
+		return static_cast<std::uint16_t>(placement.m_cpus.size());
+	}
+	//hardware_concurrency may return 0 if the value is not computable
+	return static_cast<std::uint16_t>(std::max(1U, std::thread::hardware_concurrency()));
+}
+}
+
+Worker_hash::Worker_hash(std::shared_ptr<asio::io_context> io_context, Worker_config& config, std::shared_ptr<Nonce_allocator> nonce_allocator)
 : m_io_context{std::move(io_context)}
 , m_logger{spdlog::get("logger")}
 , m_config{config}
-, m_stop{true}
 , m_log_leader{"CPU Worker " + m_config.m_id + ": " }
-, m_hash_count{0}
+, m_results{m_work, m_logger, m_log_leader, "nonce"}
+, m_placement{get_thread_placement(std::get<config::Worker_config_cpu>(m_config.m_worker_mode), *m_logger, m_log_leader)}
+, m_thread_count{get_thread_count(m_config, m_placement)}
+, m_nonce_allocator{std::move(nonce_allocator)}
+, m_verify_interval{std::get<config::Worker_config_cpu>(m_config.m_worker_mode).m_verify_interval}
+, m_thread_stats(m_thread_count)
 , m_best_leading_zeros{0}
 , m_met_difficulty_count {0}
 , m_pool_nbits{0}
 {
-	
+	auto const& worker_config_cpu = std::get<config::Worker_config_cpu>(m_config.m_worker_mode);
+	m_kernel = &select_hash_kernel(worker_config_cpu.m_kernel, *m_logger, m_log_leader);
+	m_logger->info(m_log_leader + "Using {} hashing threads.", m_thread_count);
+	if (!m_placement.m_cpus.empty())
+	{
+		m_logger->info(m_log_leader + "Pinning hashing threads to {}.", m_placement.to_string());
+	}
+	if (m_verify_interval != 0)
+	{
+		m_verifier = std::make_unique<Hash_verifier>(m_logger, m_log_leader);
+		m_logger->info(m_log_leader + "Verifying 1 in {} hashes with the reference hash.", m_verify_interval);
+	}
+	//the threads wait for the first block
+	m_work.set_consumers(m_thread_count);
+	for (std::uint16_t i = 0; i < m_thread_count; i++)
+	{
+		m_nonce_consumers.push_back(m_nonce_allocator->add_consumer(hash_batch_size, initial_lease_size, nonce_lease_duration));
+		m_run_threads.emplace_back(&Worker_hash::run, this, i);
+	}
 }
 
-Worker_hash::~Worker_hash() 
-{ 
-	//make sure the run thread exits the loop
-	m_stop = true;  
-	if (m_run_thread.joinable())
-		m_run_thread.join(); 
+Worker_hash::~Worker_hash()
+{
+	//make sure the run threads exit the loop
+	m_work.stop();
+	for (auto& run_thread : m_run_threads)
+	{
+		if (run_thread.joinable())
+			run_thread.join();
+	}
+	for (auto const nonce_consumer : m_nonce_consumers)
+	{
+		m_nonce_allocator->remove_consumer(nonce_consumer);
+	}
 }
 
-void Worker_hash::set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result)
+void Worker_hash::stop()
 {
-	//stop the existing mining loop if it is running
-	m_stop = true;
-	if (m_run_thread.joinable())
-		m_run_thread.join();
-	{
-		std::scoped_lock<std::mutex> lck(m_mtx);
-		m_found_nonce_callback = result;
-		m_block = Block_data{ block };
-
-		//set the starting nonce for each worker to something different that won't overlap with the others
-		m_starting_nonce = static_cast<uint64_t>(m_config.m_internal_id) << 48;
-		m_block.nNonce = m_starting_nonce;
-		if(nbits != 0)	// take nBits provided from pool
+	m_work.stop();
+}
+
+void Worker_hash::set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result, Clock::time_point received)
+{
+	if(nbits != 0)	// take nBits provided from pool
+	{
+		m_pool_nbits = nbits;
+	}
+
+	//build the work snapshot for the new block.  The threads only read it so no locking is needed.
+	auto work = std::make_shared<Work>();
+	work->m_found_nonce_callback = result;
+	work->m_block = Block_data{ block };
+	decodeBits(m_pool_nbits != 0 ? m_pool_nbits : work->m_block.nBits, work->m_leading_zeros_required, work->m_target64);
+	auto const header_length = work->m_block.WriteHeaderBytes(work->m_header);
+	//calculate midstate
+	work->m_skein.setMessage(work->m_header.data(), header_length);
+
+	//hand the work to the threads.  They switch after their current batch so there is nothing to wait for.
+	m_work.publish(std::move(work), received);
+}
+
+void Worker_hash::run(std::uint16_t thread_index)
+{
+	if (!m_placement.m_cpus.empty())
+	{
+		//one cpu per thread, round robin if there are more threads than cpus.
+		//pinned before mine allocates its buffers so they are first touched on the cpu's numa node
+		auto const cpu = m_placement.m_cpus[thread_index % m_placement.m_cpus.size()];
+		if (!set_thread_affinity({ cpu }))
 		{
-			m_pool_nbits = nbits;
+			m_logger->warn(m_log_leader + "Failed to pin hashing thread {} to cpu {}.", thread_index, cpu);
 		}
-
-		std::vector<unsigned char> headerB = m_block.GetHeaderBytes();
-		//calculate midstate
-		m_skein.setMessage(headerB);
 	}
-	//restart the mining loop
-	m_stop = false;
-	m_run_thread = std::thread(&Worker_hash::run, this);
+	std::uint64_t generation = 0;
+	while (auto work = m_work.wait(generation))
+	{
+		mine(thread_index, work, generation);
+	}
 }
 
-void Worker_hash::run()
+void Worker_hash::mine(std::uint16_t thread_index, std::shared_ptr<Work const> const& work, std::uint64_t generation)
 {
-	while (!m_stop)
-	{
-		std::scoped_lock<std::mutex> lck(m_mtx);
-		//calculate the remainder of the skein hash starting from the midstate.
-		m_skein.calculateHash();
-		//run keccak on the result from skein
-		NexusKeccak keccak(m_skein.getHash());
-		keccak.calculateHash();
-		uint64_t keccakHash = keccak.getResult();
-		uint64_t nonce = m_skein.getNonce();
-		//check the result for leading zeros
-		if ((keccakHash & leading_zero_mask()) == 0)
+	//the midstate is shared by all threads.  Each thread works on its own copy.
+	NexusSkein const skein = work->m_skein;
+	//the nonces come in leases from the allocator shared by all workers
+	auto const nonce_consumer = m_nonce_consumers[thread_index];
+	m_nonce_allocator->new_work(nonce_consumer);
+	auto lease = m_nonce_allocator->lease(nonce_consumer);
+	uint64_t nonce = lease.m_first;
+	auto& hash_count = m_thread_stats[thread_index].m_hash_count;
+	auto const hash_range = m_kernel->hashRange;
+	int const lanes = m_kernel->lanes;
+	//the kernel reports the nonces that meet the target and the ones good enough for the best leading zeros statistic.
+	//the hash of every candidate is already known so checking them costs no extra hashing.
+	uint64_t const threshold = std::max<uint64_t>(work->m_target64, ~0ULL >> best_leading_zeros_reported);
+	//sampling for the hash verifier
+	std::uint64_t const verify_interval = m_verifier ? m_verify_interval : 0;
+	std::uint64_t thread_hash_count = 0;
+	std::uint64_t next_verify = verify_interval;
+	//shares ownership of the work snapshot
+	std::shared_ptr<Block_data::Header_bytes const> header{ work, &work->m_header };
+	//reused for every batch so the loop does not allocate
+	std::vector<NexusSkein::Candidate> candidates;
+	candidates.reserve(NexusSkein::lanesAVX512);
+	m_work.mark_started(generation);
+	while (!m_work.changed(generation))
+	{
+		candidates.clear();
+		if (nonce == lease.end())
+		{
+			lease = m_nonce_allocator->lease(nonce_consumer);
+			nonce = lease.m_first;
+		}
+		//stay inside the lease
+		std::uint64_t count = std::min(hash_batch_size, lease.end() - nonce);
+		if (verify_interval != 0 && thread_hash_count >= next_verify)
+		{
+			//one kernel call with every nonce reported so the verifier checks the same code path that mines
+			count = std::min<std::uint64_t>(count, lanes);
+			(skein.*hash_range)(nonce, count, ~0ULL, candidates);
+			//rotate through the lanes so every lane of the kernel gets checked
+			auto const& sample = candidates[(next_verify / verify_interval) % count];
+			m_verifier->submit(header, sample.nonce, sample.result);
+			next_verify += verify_interval;
+			candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+				[threshold](NexusSkein::Candidate const& candidate) { return candidate.result > threshold; }), candidates.end());
+		}
+		else
 		{
-			m_logger->info(m_log_leader + "Found a nonce candidate {}", nonce);
-			m_skein.setNonce(nonce);
-			//verify the difficulty
-			if (difficulty_check())
+			if (verify_interval != 0)
 			{
-				++m_met_difficulty_count;
-				//update the block with the nonce and call the callback function;
-				m_block.nNonce = nonce;
-				{
-					if (m_found_nonce_callback)
-					{
-						::asio::post([self = shared_from_this()]()
-						{
-							self->m_found_nonce_callback(self->m_config.m_internal_id, std::make_unique<Block_data>(self->m_block));
-						});
-					}
-					else
-					{
-						m_logger->debug(m_log_leader + "Miner callback function not set.");
-					}
-				}
+				//end the batch at the next sample.  Whole kernel calls only.
+				count = std::min(count, (next_verify - thread_hash_count + lanes - 1) / lanes * lanes);
+			}
+			//skein from the midstate followed by keccak.  Only the upper 64 bits of the hash are computed.
+			(skein.*hash_range)(nonce, count, threshold, candidates);
+		}
 
+		for (auto const& candidate : candidates)
+		{
+			if (difficulty_check(*work, candidate))
+			{
+				++m_met_difficulty_count;
+				//the io thread builds the block from the work of this generation
+				submit_result({ m_config.m_internal_id, generation, candidate.nonce, static_cast<double>(63 - findMSB(candidate.result)) });
 			}
 		}
-		m_skein.setNonce(++nonce);	
-		++m_hash_count;
+		nonce += count;
+		thread_hash_count += count;
+		//only this thread writes the counter.  update_statistics reads it without synchronising.
+		hash_count.store(hash_count.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
 	}
 }
 
-void Worker_hash::update_statistics(stats::Collector& stats_collector)
+void Worker_hash::submit_result(Result const& result)
 {
-	std::scoped_lock<std::mutex> lck(m_mtx);
+	m_results.submit(result, [this]()
+	{
+		//keeps the worker alive until the drain ran
+		::asio::post(*m_io_context, [self = shared_from_this()]()
+		{
+			self->m_results.drain();
+		});
+	});
+}
 
+void Worker_hash::update_statistics(stats::Collector& stats_collector)
+{
 	auto hash_stats = std::get<stats::Hash>(stats_collector.get_worker_stats(m_config.m_internal_id));
-	hash_stats.m_hash_count = m_hash_count;
-	hash_stats.m_best_leading_zeros = m_best_leading_zeros;
-	hash_stats.m_met_difficulty_count = m_met_difficulty_count;
+	hash_stats.m_hash_count = 0;
+	for (auto const& thread_stats : m_thread_stats)
+	{
+		hash_stats.m_hash_count += thread_stats.m_hash_count.load(std::memory_order_relaxed);
+	}
+	hash_stats.m_best_leading_zeros = m_best_leading_zeros.load(std::memory_order_relaxed);
+	hash_stats.m_met_difficulty_count = m_met_difficulty_count.load(std::memory_order_relaxed);
+	//mismatches between the mining kernel and the reference hash
+	hash_stats.m_hash_error_count = m_verifier ? m_verifier->get_error_count() : 0;
+	auto const switch_latency = m_work.get_switch_latency();
+	hash_stats.m_block_switch_p50_us = static_cast<std::uint32_t>(switch_latency.percentile(0.5).count());
+	hash_stats.m_block_switch_p99_us = static_cast<std::uint32_t>(switch_latency.percentile(0.99).count());
+	hash_stats.m_max_block_switch_us = static_cast<std::uint32_t>(switch_latency.max().count());
+	hash_stats.m_placement = m_placement.to_string();
 
 	stats_collector.update_worker_stats(m_config.m_internal_id, hash_stats);
 
 }
 
 
-bool Worker_hash::difficulty_check()
+bool Worker_hash::difficulty_check(Work const& work, NexusSkein::Candidate const& candidate)
 {
-	//perform additional difficulty filtering prior to submitting the nonce 
-
-	//leading zeros in bits required of the hash for it to pass the current difficulty.
-	int leadingZerosRequired;
-	uint64_t difficultyTest64;
-	decodeBits(m_pool_nbits != 0 ? m_pool_nbits : m_block.nBits, leadingZerosRequired, difficultyTest64);
-	m_skein.calculateHash();
-	//run keccak on the result from skein
-	NexusKeccak keccak(m_skein.getHash());
-	keccak.calculateHash();
-	uint64_t keccakHash = keccak.getResult();
-	int hashActualLeadingZeros = 63 - findMSB(keccakHash);
-	m_logger->info(m_log_leader + "Leading Zeros Found/Required {}/{}", hashActualLeadingZeros, leadingZerosRequired);
-	if (hashActualLeadingZeros > m_best_leading_zeros)
-	{
-		m_best_leading_zeros = hashActualLeadingZeros;
+	//the kernel already computed the upper 64 bits of the hash.  Compare them with the target decoded in set_block.
+	int hashActualLeadingZeros = 63 - findMSB(candidate.result);
+	//several threads may find a candidate at the same time
+	int best_leading_zeros = m_best_leading_zeros.load(std::memory_order_relaxed);
+	while (hashActualLeadingZeros > best_leading_zeros &&
+		!m_best_leading_zeros.compare_exchange_weak(best_leading_zeros, hashActualLeadingZeros, std::memory_order_relaxed))
+	{
 	}
 	//check the hash result is less than the difficulty.  We truncate to just use the upper 64 bits for easier calculation.
-	if (keccakHash <= difficultyTest64)
+	if (candidate.result <= work.m_target64)
 	{
-		m_logger->info(m_log_leader + "Nonce passes difficulty check.");
+		m_logger->info(m_log_leader + "Nonce {} passes difficulty check. Leading Zeros Found/Required {}/{}", candidate.nonce,
+			hashActualLeadingZeros, work.m_leading_zeros_required);
 		return true;
 	}
 	else
 	{
-		//m_logger->warn(m_log_leader + "Nonce fails difficulty check.");
 		return false;
 	}
 }
 
-uint64_t Worker_hash::leading_zero_mask()
-{
-	return ((1ull << leading_zeros_required) - 1) << (64 - leading_zeros_required);
-}
-
 void Worker_hash::reset_statistics()
 {
-	m_hash_count = 0;
+	for (auto& thread_stats : m_thread_stats)
+	{
+		thread_stats.m_hash_count = 0;
+	}
 	m_best_leading_zeros = 0;
 	m_met_difficulty_count = 0;
+	m_work.reset_switch_latency();
+	if (m_verifier)
+	{
+		m_verifier->reset_statistics();
+	}
 }
 
 }
-}
\ No newline at end of file
+}
@@ -4,6 +4,7 @@
 #include "prime/prime.hpp"
 #include "prime/chain_sieve.hpp"
 #include "block.hpp"
+#include "cpu/thread_affinity.hpp"
 #include <asio.hpp>
 #include <primesieve.hpp>
 #include <sstream> 
@@ -13,91 +14,173 @@ namespace nexusminer
 {
 namespace cpu
 {
-Worker_prime::Worker_prime(std::shared_ptr<asio::io_context> io_context, config::Worker_config& config)
+
+namespace
+{
+std::uint16_t get_thread_count(config::Worker_config const& config, Thread_placement const& placement)
+{
+	auto const& worker_config_cpu = std::get<config::Worker_config_cpu>(config.m_worker_mode);
+	if (worker_config_cpu.m_threads != 0)
+	{
+		return worker_config_cpu.m_threads;
+	}
+	//one thread per pinned cpu.  Every thread keeps its own multiples of the sieving primes so an unpinned worker
+	//stays at one thread.
+	if (!placement.m_cpus.empty())
+	{
+		return static_cast<std::uint16_t>(placement.m_cpus.size());
+	}
+	return 1;
+}
+}
+
+Worker_prime::Worker_prime(std::shared_ptr<asio::io_context> io_context, config::Worker_config& config,
+	std::shared_ptr<Nonce_allocator> nonce_allocator)
 	: m_io_context{ std::move(io_context) }
 	, m_logger{ spdlog::get("logger") }
 	, m_config{ config }
 	, m_prime_helper{std::make_unique<Prime>()}
-	, m_segmented_sieve{std::make_unique<Sieve>()}
-	, m_stop{ true }
 	, m_log_leader{ "CPU Worker " + m_config.m_id + ": " }
+	, m_results{ m_work, m_logger, m_log_leader, "chain" }
+	, m_placement{ get_thread_placement(std::get<config::Worker_config_cpu>(m_config.m_worker_mode), *m_logger, m_log_leader) }
+	, m_thread_count{ get_thread_count(m_config, m_placement) }
+	, m_sieves(m_thread_count)
+	, m_nonce_allocator{ std::move(nonce_allocator) }
 	, m_primes{ 0 }
 	, m_chains{ 0 }
 	, m_difficulty{ 0 }
 	, m_pool_nbits{ 0 }
 {
-	m_segmented_sieve->generate_sieving_primes();
+	m_logger->info(m_log_leader + "Using {} mining threads.", m_thread_count);
+	if (!m_placement.m_cpus.empty())
+	{
+		m_logger->info(m_log_leader + "Pinning the mining threads to {}.", m_placement.to_string());
+	}
+	//each mining thread creates its sieve and then waits for the first block.
+	//the first thread generates the sieving primes.  The others share them so they start after it.
+	m_work.set_consumers(m_thread_count);
+	for (std::uint16_t i = 0; i < m_thread_count; i++)
+	{
+		std::promise<void> sieve_ready;
+		auto sieve_created = sieve_ready.get_future();
+		m_run_threads.emplace_back(&Worker_prime::run, this, i, std::move(sieve_ready));
+		sieve_created.wait();
+	}
+	//one lease per round.  Each thread gets a whole number of segments of it.
+	auto const round_granularity = static_cast<std::uint64_t>(m_sieves[0]->get_segment_size()) * m_thread_count;
+	m_nonce_consumer = m_nonce_allocator->add_consumer(round_granularity, initial_lease_segments * round_granularity, nonce_lease_duration);
 	fermat_performance_test();
 	m_chain_histogram = std::vector<std::uint32_t>(10, 0);
-	m_segmented_sieve->reset_stats();
+	for (auto& sieve : m_sieves)
+	{
+		sieve->reset_stats();
+	}
 }
 
 Worker_prime::~Worker_prime() noexcept
 {
-	//make sure the run thread exits the loop
-	m_stop = true;
-	if (m_run_thread.joinable())
-		m_run_thread.join();
+	//make sure the run threads exit the loop
+	m_work.stop();
+	for (auto& run_thread : m_run_threads)
+	{
+		if (run_thread.joinable())
+			run_thread.join();
+	}
+	m_nonce_allocator->remove_consumer(m_nonce_consumer);
+}
+
+void Worker_prime::stop()
+{
+	m_work.stop();
 }
 
-void Worker_prime::set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result)
+void Worker_prime::set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result, Clock::time_point received)
 {
-	//stop the existing mining loop if it is running
-	m_stop = true;
-	if (m_run_thread.joinable())
+	auto work = std::make_shared<Work>();
+	work->m_found_nonce_callback = result;
+	work->m_block = Block_data{ block };
+	if (nbits != 0)	// take nBits provided from pool
 	{
-		m_run_thread.join();
+		m_pool_nbits = nbits;
 	}
 
+	m_difficulty = m_pool_nbits != 0 ? m_pool_nbits : work->m_block.nBits;
+	work->m_difficulty = m_difficulty;
+	bool excludeNonce = true;  //prime block hash excludes the nonce
+	Block_data::Header_bytes header;
+	auto const header_length = work->m_block.WriteHeaderBytes(header, excludeNonce);
+	//calculate the block hash
+	NexusSkein skein;
+	skein.setMessage(header.data(), header_length);
+	skein.calculateHash();
+	NexusSkein::stateType hash = skein.getHash();
+
+	//keccak
+	NexusKeccak keccak(hash);
+	keccak.calculateHash();
+	NexusKeccak::k_1024 keccakFullHash_i = keccak.getHashResult();
+	keccakFullHash_i.isBigInt = true;
+	uint1k keccakFullHash("0x" + keccakFullHash_i.toHexString(true));
+	work->m_base_hash = keccakFullHash;
+	//Now we have the hash of the block header.  We use this to feed the miner. 
+
+	//hand the work to the mining threads.  They switch after the current segment so there is nothing to wait for.
+	m_work.publish(std::move(work), received);
+}
+
+void Worker_prime::run(std::uint16_t thread_index, std::promise<void> sieve_ready)
+{
+	if (!m_placement.m_cpus.empty())
 	{
-		std::scoped_lock<std::mutex> lck(m_mtx);
-		m_found_nonce_callback = result;
-		m_block = Block_data{ block };
-		if (nbits != 0)	// take nBits provided from pool
+		//one cpu per thread, round robin if there are more threads than cpus
+		auto const cpu = m_placement.m_cpus[thread_index % m_placement.m_cpus.size()];
+		if (!set_thread_affinity({ cpu }))
 		{
-			m_pool_nbits = nbits;
+			m_logger->warn(m_log_leader + "Failed to pin mining thread {} to cpu {}.", thread_index, cpu);
 		}
+	}
+	//the sieve is allocated after pinning so its memory is first touched on the chosen numa node
+	if (thread_index == 0)
+	{
+		m_cache_sizes = get_cache_sizes();
+	}
+	auto sieve = std::make_unique<Sieve>(m_cache_sizes);
+	if (thread_index == 0)
+	{
+		m_logger->info(m_log_leader + "Sieve segments of {} integers for {} KB L1d and {} KB L2 cache.", sieve->get_segment_size(),
+			m_cache_sizes.m_l1d / 1024, m_cache_sizes.m_l2 / 1024);
+		sieve->generate_sieving_primes();
+	}
+	else
+	{
+		sieve->share_sieving_primes(*m_sieves[0]);
+	}
+	m_sieves[thread_index] = std::move(sieve);
+	sieve_ready.set_value();
 
-		m_difficulty = m_pool_nbits != 0 ? m_pool_nbits : m_block.nBits;
-		bool excludeNonce = true;  //prime block hash excludes the nonce
-		std::vector<unsigned char> headerB = m_block.GetHeaderBytes(excludeNonce);
-		//calculate the block hash
-		NexusSkein skein;
-		skein.setMessage(headerB);
-		skein.calculateHash();
-		NexusSkein::stateType hash = skein.getHash();
-
-		//keccak
-		NexusKeccak keccak(hash);
-		keccak.calculateHash();
-		NexusKeccak::k_1024 keccakFullHash_i = keccak.getHashResult();
-		keccakFullHash_i.isBigInt = true;
-		uint1k keccakFullHash("0x" + keccakFullHash_i.toHexString(true));
-		m_base_hash = keccakFullHash;
-		//Now we have the hash of the block header.  We use this to feed the miner. 
-
-		//set the starting nonce for each worker to something different that won't overlap with the others
-		m_starting_nonce = static_cast<uint64_t>(m_config.m_internal_id) << 48;
-		m_nonce = m_starting_nonce;
-
-		//set the sieve start range
-		uint1k startprime = m_base_hash + m_nonce;
-		m_segmented_sieve->set_sieve_start(startprime);
-		//update the starting nonce to reflect the actual sieve start used
-		m_nonce = static_cast<uint64_t>(m_segmented_sieve->get_sieve_start() - m_base_hash);
-		//m_logger->debug("starting nonce: {}", m_nonce);
-		//clear out any old chains from the last block
-		m_segmented_sieve->clear_chains();
+	std::uint64_t generation = 0;
+	while (auto work = m_work.wait(generation))
+	{
+		mine(thread_index, *work, generation);
 	}
-	//restart the mining loop
-	m_stop = false;
-	m_run_thread = std::thread(&Worker_prime::run, this);
 }
 
-void Worker_prime::run()
+void Worker_prime::mine(std::uint16_t thread_index, Work const& work, std::uint64_t generation)
 {
-	m_segmented_sieve->calculate_starting_multiples();
-	uint32_t segment_size = m_segmented_sieve->get_segment_size();
+	//the sieve is only touched by its mining thread so it is set up for the new block here
+	Sieve& sieve = *m_sieves[thread_index];
+	Block_data block = work.m_block;
+	bool const last_chunk = thread_index + 1 == m_thread_count;
+	//the sieve offsets come in rounds leased from the allocator shared by all workers.  Each thread sieves its chunk of the round.
+	std::uint64_t round = 0;
+	std::uint64_t chunk_first = 0;
+	std::uint64_t chunk_size = 0;
+	if (!get_chunk(thread_index, round, generation, chunk_first, chunk_size))
+	{
+		return;
+	}
+	std::uint64_t nonce = start_sieve(sieve, work.m_base_hash, chunk_first);
+	uint32_t segment_size = sieve.get_segment_size();
 	uint64_t find_chains_ms = 0;
 	uint64_t sieving_ms = 0;
 	uint64_t test_chains_ms = 0;
@@ -108,56 +191,75 @@ void Worker_prime::run()
 
 	auto start = std::chrono::steady_clock::now();
 	auto interval_start = std::chrono::steady_clock::now();
-	while (!m_stop)
+	m_work.mark_started(generation);
+	while (!m_work.changed(generation))
 	{
-		m_segmented_sieve->reset_sieve();
-		m_segmented_sieve->clear_chains();
+		if (low == chunk_size)
+		{
+			//continue with the chunk of the next round.  The starting multiples are calculated again.
+			finish_round(round, generation);
+			round++;
+			if (!get_chunk(thread_index, round, generation, chunk_first, chunk_size))
+			{
+				return;
+			}
+			nonce = start_sieve(sieve, work.m_base_hash, chunk_first);
+			low = 0;
+		}
+		sieve.reset_sieve();
+		sieve.clear_chains();
 
 		// current segment = [low, high]
 		high = low + segment_size - 1;
 		uint64_t sieve_size = (high - low) / 30 + 1;
-		m_range_searched += segment_size;
+		m_range_searched.fetch_add(segment_size, std::memory_order_relaxed);
 		range_searched_this_cycle += segment_size;
 
 		auto sieve_start = std::chrono::steady_clock::now();
-		m_segmented_sieve->sieve_segment();
+		sieve.sieve_segment();
 		auto sieve_stop = std::chrono::steady_clock::now();
 		auto sieve_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(sieve_stop - sieve_start);
 		sieving_ms += sieve_elapsed.count();
 		auto find_chains_start = std::chrono::steady_clock::now();
-		m_segmented_sieve->find_chains(low, false);
+		//the chains up to the first empty byte of a chunk belong to the thread of the previous chunk
+		uint64_t first_byte = 0;
+		if (low == 0 && thread_index != 0)
+		{
+			auto handoff = sieve.get_chain_handoff();
+			first_byte = handoff.size();
+			publish_handoff(thread_index, round, generation, std::move(handoff));
+		}
+		sieve.find_chains(low, false, first_byte);
+		if (low + segment_size == chunk_size)
+		{
+			//finish the chains running into the next chunk.  The last chunk ends at the end of the lease.
+			std::vector<std::uint8_t> handoff;
+			if (!last_chunk && !wait_handoff(thread_index, round, generation, handoff))
+			{
+				return;
+			}
+			sieve.finish_chains(handoff, low + segment_size);
+		}
 		auto find_chains_stop = std::chrono::steady_clock::now();
 		auto find_chains_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(find_chains_stop - find_chains_start);
 		find_chains_ms += find_chains_elapsed.count();
 		auto test_chains_start = std::chrono::steady_clock::now();
-		m_segmented_sieve->test_chains();
+		sieve.test_chains();
 		auto test_chains_stop = std::chrono::steady_clock::now();
 		auto test_chains_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(test_chains_stop - test_chains_start);
 		test_chains_ms += test_chains_elapsed.count();
 		//check difficulty of any chains that passed through the filter
-		for (auto x : m_segmented_sieve->m_long_chain_starts)
+		for (auto x : sieve.m_long_chain_starts)
 		{
-			m_block.nNonce = m_nonce + x;
-			uint1k chain_start = m_base_hash + m_block.nNonce;
+			block.nNonce = nonce + x;
+			uint1k chain_start = work.m_base_hash + block.nNonce;
 			double difficulty = getDifficulty(chain_start);
-			m_segmented_sieve->m_best_chain = std::max(difficulty, m_segmented_sieve->m_best_chain);
-			m_logger->info("Actual difficulty {} required {}", difficulty, getNetworkDifficulty());
-			if (difficulty_check(chain_start))
+			sieve.m_best_chain = std::max(difficulty, sieve.m_best_chain.load());
+			m_logger->info("Actual difficulty {} required {}", difficulty, getNetworkDifficulty(work.m_difficulty));
+			if (difficulty >= getNetworkDifficulty(work.m_difficulty))
 			{
 				//we found a valid chain.  submit it. 
-				{
-					if (m_found_nonce_callback)
-					{
-						::asio::post([self = shared_from_this()]()
-						{
-							self->m_found_nonce_callback(self->m_config.m_internal_id, std::make_unique<Block_data>(self->m_block));
-						});
-					}
-					else
-					{
-						m_logger->debug(m_log_leader + "Miner callback function not set.");
-					}
-				}
+				submit_result({ m_config.m_internal_id, generation, block.nNonce, difficulty });
 			}
 		}
 		low += segment_size;
@@ -170,16 +272,16 @@ void Worker_prime::run()
 			std::cout << "--debug--" << std::endl;
 			auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
 			elapsed_ms = elapsed.count();
-			double chains_per_mm = 1.0e6 * m_segmented_sieve->m_chain_count / m_range_searched;
-			double chains_per_sec = 1.0e3 * m_segmented_sieve->m_chain_count / elapsed_ms;
-			double fermat_positive_rate = 1.0 * m_segmented_sieve->m_fermat_prime_count / m_segmented_sieve->m_fermat_test_count;
-			double fermat_tests_per_chain = 1.0 * m_segmented_sieve->m_fermat_test_count / m_segmented_sieve->m_chain_count;
+			double chains_per_mm = 1.0e6 * sieve.m_chain_count / m_range_searched;
+			double chains_per_sec = 1.0e3 * sieve.m_chain_count / elapsed_ms;
+			double fermat_positive_rate = 1.0 * sieve.m_fermat_prime_count / sieve.m_fermat_test_count;
+			double fermat_tests_per_chain = 1.0 * sieve.m_fermat_test_count / sieve.m_chain_count;
 			std::cout << std::fixed << std::setprecision(2) << m_range_searched / 1.0e9 << " billion integers searched." <<
-				" Found " << m_segmented_sieve->m_chain_count << " chain candidates. (" << chains_per_mm << " chains per million integers)" << std::endl;
-			std::cout << "Fermat Tests: " << m_segmented_sieve->m_fermat_test_count << " Fermat Primes: " << m_segmented_sieve->m_fermat_prime_count <<
+				" Found " << sieve.m_chain_count << " chain candidates. (" << chains_per_mm << " chains per million integers)" << std::endl;
+			std::cout << "Fermat Tests: " << sieve.m_fermat_test_count << " Fermat Primes: " << sieve.m_fermat_prime_count <<
 				" Fermat Positive Rate: " << std::fixed << std::setprecision(3) <<
 				100.0 * fermat_positive_rate << "% Fermat tests per million integers sieved: " <<
-				1.0e6 * m_segmented_sieve->m_fermat_test_count / m_range_searched << std::endl;
+				1.0e6 * sieve.m_fermat_test_count / m_range_searched << std::endl;
 
 			std::cout << "Search rate: " << std::fixed << std::setprecision(1) << range_searched_this_cycle / (elapsed.count() * 1.0e3) << " million integers per second." << std::endl;
 			double predicted_8chain_positivity_rate = std::pow(fermat_positive_rate, 8);
@@ -196,6 +298,112 @@ void Worker_prime::run()
 	}
 }
 
+void Worker_prime::submit_result(Result const& result)
+{
+	m_results.submit(result, [this]()
+	{
+		//keeps the worker alive until the drain ran
+		::asio::post(*m_io_context, [self = shared_from_this()]()
+		{
+			self->m_results.drain();
+		});
+	});
+}
+
+bool Worker_prime::get_chunk(std::uint16_t thread_index, std::uint64_t round, std::uint64_t generation, std::uint64_t& first, std::uint64_t& size)
+{
+	std::scoped_lock<std::mutex> lck(m_round_mtx);
+	if (generation < m_round_generation)
+	{
+		return false;
+	}
+	if (generation > m_round_generation)
+	{
+		//first thread on the new work.  The rounds of the old work are void.
+		m_rounds.clear();
+		m_first_round = 0;
+		m_round_generation = generation;
+		m_nonce_allocator->new_work(m_nonce_consumer);
+	}
+	while (m_first_round + m_rounds.size() <= round)
+	{
+		auto const lease = m_nonce_allocator->lease(m_nonce_consumer);
+		Round next;
+		next.m_first = lease.m_first;
+		next.m_chunk_size = lease.m_count / m_thread_count;
+		next.m_handoff.resize(m_thread_count);
+		next.m_handoff_ready.resize(m_thread_count, false);
+		m_rounds.push_back(std::move(next));
+	}
+	auto const& current = m_rounds[round - m_first_round];
+	first = current.m_first + thread_index * current.m_chunk_size;
+	size = current.m_chunk_size;
+	return true;
+}
+
+void Worker_prime::publish_handoff(std::uint16_t thread_index, std::uint64_t round, std::uint64_t generation, std::vector<std::uint8_t> handoff)
+{
+	{
+		std::scoped_lock<std::mutex> lck(m_round_mtx);
+		if (generation != m_round_generation)
+		{
+			return;
+		}
+		auto& current = m_rounds[round - m_first_round];
+		current.m_handoff[thread_index] = std::move(handoff);
+		current.m_handoff_ready[thread_index] = true;
+	}
+	m_round_cv.notify_all();
+}
+
+bool Worker_prime::wait_handoff(std::uint16_t thread_index, std::uint64_t round, std::uint64_t generation, std::vector<std::uint8_t>& handoff)
+{
+	std::unique_lock<std::mutex> lck(m_round_mtx);
+	for (;;)
+	{
+		if (generation != m_round_generation || m_work.changed(generation))
+		{
+			return false;
+		}
+		auto const& current = m_rounds[round - m_first_round];
+		if (current.m_handoff_ready[thread_index + 1])
+		{
+			handoff = current.m_handoff[thread_index + 1];
+			return true;
+		}
+		//polled because a new block doesn't notify m_round_cv.  The next thread is usually done long before.
+		m_round_cv.wait_for(lck, std::chrono::milliseconds(10));
+	}
+}
+
+void Worker_prime::finish_round(std::uint64_t round, std::uint64_t generation)
+{
+	std::scoped_lock<std::mutex> lck(m_round_mtx);
+	if (generation != m_round_generation)
+	{
+		return;
+	}
+	m_rounds[round - m_first_round].m_finished++;
+	while (!m_rounds.empty() && m_rounds.front().m_finished == m_thread_count)
+	{
+		m_rounds.pop_front();
+		m_first_round++;
+	}
+}
+
+std::uint64_t Worker_prime::start_sieve(Sieve& sieve, uint1k const& base_hash, std::uint64_t nonce)
+{
+	//set the sieve start range
+	sieve.set_sieve_start(base_hash + nonce);
+	//the actual sieve start moves up by less than 30.  The chunks and the leases start at multiples of 30 so every chunk moves
+	//up by the same amount.  They stay consecutive and don't overlap the chunks of other leases.
+	auto const sieve_nonce = static_cast<uint64_t>(sieve.get_sieve_start() - base_hash);
+	//clear out any old chains from the last block
+	sieve.clear_chains();
+	sieve.calculate_starting_multiples();
+	return sieve_nonce;
+}
+
 double Worker_prime::getDifficulty(uint1k p)
 {
 	std::vector<unsigned int> offsets_to_test;
@@ -204,14 +412,9 @@ double Worker_prime::getDifficulty(uint1k p)
 	return difficulty;
 }
 
-double Worker_prime::getNetworkDifficulty()
+double Worker_prime::getNetworkDifficulty(std::uint32_t nbits)
 {
-	return m_difficulty / 10000000.0;
-}
-
-bool Worker_prime::difficulty_check(uint1k p)
-{
-	return getDifficulty(p) >= getNetworkDifficulty();
+	return nbits / 10000000.0;
 }
 
 
@@ -229,12 +432,28 @@ LLC::CBigNum Worker_prime::boost_uint1024_t_to_CBignum(uint1k p)
 void Worker_prime::update_statistics(stats::Collector& stats_collector)
 {
 	auto prime_stats = std::get<stats::Prime>(stats_collector.get_worker_stats(m_config.m_internal_id));
-	prime_stats.m_primes = m_segmented_sieve->m_fermat_prime_count;
-	prime_stats.m_chains = m_segmented_sieve->m_chain_count;
+	//summed over the sieves of the threads without stopping them
+	prime_stats.m_primes = 0;
+	prime_stats.m_chains = 0;
+	prime_stats.m_chain_histogram = std::vector<std::uint32_t>(10, 0);
+	prime_stats.m_most_difficult_chain = 0;
+	for (auto const& sieve : m_sieves)
+	{
+		prime_stats.m_primes += sieve->m_fermat_prime_count;
+		prime_stats.m_chains += sieve->m_chain_count;
+		for (std::size_t i = 0; i < prime_stats.m_chain_histogram.size() && i < sieve->m_chain_histogram.size(); i++)
+		{
+			prime_stats.m_chain_histogram[i] += sieve->m_chain_histogram[i];
+		}
+		prime_stats.m_most_difficult_chain = std::max(prime_stats.m_most_difficult_chain, sieve->m_best_chain.load());
+	}
 	prime_stats.m_difficulty = m_difficulty;
-	prime_stats.m_chain_histogram = m_segmented_sieve->m_chain_histogram;
-	prime_stats.m_range_searched = m_range_searched;
-	prime_stats.m_most_difficult_chain = m_segmented_sieve->m_best_chain;
+	prime_stats.m_range_searched = m_range_searched.load(std::memory_order_relaxed);
+	auto const switch_latency = m_work.get_switch_latency();
+	prime_stats.m_block_switch_p50_us = static_cast<std::uint32_t>(switch_latency.percentile(0.5).count());
+	prime_stats.m_block_switch_p99_us = static_cast<std::uint32_t>(switch_latency.percentile(0.99).count());
+	prime_stats.m_max_block_switch_us = static_cast<std::uint32_t>(switch_latency.max().count());
+	prime_stats.m_placement = m_placement.to_string();
 
 
 	stats_collector.update_worker_stats(m_config.m_internal_id, prime_stats);
@@ -267,7 +486,7 @@ void Worker_prime::fermat_performance_test()
 	auto start = std::chrono::steady_clock::now();
 	for (unsigned i = 0; i < sample_size; ++i)
 	{
-		p_count += 1 ? m_segmented_sieve->primality_test(big_uints[i]) : 0;
+		p_count += 1 ? m_sieves[0]->primality_test(big_uints[i]) : 0;
 	}
 	auto end = std::chrono::steady_clock::now();
 	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
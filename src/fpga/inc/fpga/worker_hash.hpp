@@ -3,7 +3,10 @@
 
 #include <memory>
 #include <mutex>
+#include <optional>
 #include "worker.hpp"
+#include "nonce_allocator.hpp"
+#include "latency_samples.hpp"
 #include "hash/nexus_skein.hpp"
 #include "hash/nexus_keccak.hpp"
 #include "hash/nexus_hash_utils.hpp"
@@ -22,20 +25,23 @@ public:
 
     using Worker_config = config::Worker_config;
 
-    Worker_hash(std::shared_ptr<asio::io_context> io_context, Worker_config& config);
+    Worker_hash(std::shared_ptr<asio::io_context> io_context, Worker_config& config, std::shared_ptr<Nonce_allocator> nonce_allocator);
     ~Worker_hash();
 
     // Sets a new block (nexus data type) for the miner worker. The miner worker must reset the current work.
     // When  the worker finds a new block, the BlockFoundHandler has to be called with the found BlockData
-    void set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result) override;
+    void set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result, Clock::time_point received) override;
     void update_statistics(stats::Collector& stats_collector) override;
+    void stop() override;
 
 private:
 
     void start_read();
     void handle_read(const asio::error_code& error, std::size_t bytes_transferred);
-    bool difficulty_check();
-    void send_block_to_fpga();
+    bool difficulty_check(uint64_t nonce);
+    // m_mtx held.  received is empty for a resend of the current block.
+    void send_block_to_fpga(std::optional<Clock::time_point> received);
+    void start_write();
 
     static constexpr int baud = 230400;
     static constexpr int workPackageLength = 224; //bytes
@@ -49,8 +55,22 @@ private:
     std::string m_serial_port_path;
     Worker::Block_found_handler m_found_nonce_callback;
     NexusSkein m_skein;
+    //the fpga counts up from the starting nonce on its own and can't be given more during a block.
+    //It gets one large lease per block.
+    static constexpr uint64_t fpga_lease_size = 1ULL << 48;
+    std::shared_ptr<Nonce_allocator> m_nonce_allocator;
+    std::size_t m_nonce_consumer;
     uint64_t m_starting_nonce = 0;
     Block_data m_block;
+    //the work package being written to the fpga.  It has to outlive the asynchronous write.
+    std::vector<unsigned char> m_work_package;
+    //only one write is in flight.  A package for a newer block waits here and replaces an older waiting one.
+    std::vector<unsigned char> m_next_work_package;
+    std::optional<Clock::time_point> m_next_received;
+    bool m_next_pending = false;
+    bool m_writing = false;
+    //the read of the nonces runs across blocks and is never canceled
+    bool m_reading = false;
     std::mutex m_mtx;
     std::string m_log_leader;
 
@@ -61,8 +81,13 @@ private:
     int m_best_leading_zeros;
     int m_met_difficulty_count;
     int m_hash_error_count;
+    //time from receiving a block until the fpga has its work package
+    Latency_samples m_switch_latency;
 
     std::uint32_t m_pool_nbits;
+    //the pool or network target decoded once per block in set_block
+    int m_leading_zeros_required;
+    uint64_t m_target64;
 };
 
 }
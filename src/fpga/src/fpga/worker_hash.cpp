@@ -7,16 +7,20 @@ namespace nexusminer
 {
 namespace fpga
 {
-Worker_hash::Worker_hash(std::shared_ptr<asio::io_context> io_context, Worker_config& config)
+Worker_hash::Worker_hash(std::shared_ptr<asio::io_context> io_context, Worker_config& config, std::shared_ptr<Nonce_allocator> nonce_allocator)
 	: m_io_context{ std::move(io_context) }
 	, m_logger{ spdlog::get("logger") }
 	, m_config{config}
 	, m_serial{ *m_io_context }
+	, m_nonce_allocator{ std::move(nonce_allocator) }
+	, m_nonce_consumer{ m_nonce_allocator->add_consumer(1, fpga_lease_size, std::chrono::milliseconds{0}) }
 	, m_nonce_candidates_recieved{ 0 }
 	, m_best_leading_zeros{ 0 }
 	, m_met_difficulty_count{ 0 }
 	, m_hash_error_count{ 0 }
 	, m_pool_nbits{0}
+	, m_leading_zeros_required{0}
+	, m_target64{0}
 {
 	auto& worker_config_fpga = std::get<config::Worker_config_fpga>(m_config.m_worker_mode);
 	m_receive_nonce_buffer.resize(responseLength);
@@ -38,21 +42,28 @@ Worker_hash::Worker_hash(std::shared_ptr<asio::io_context> io_context, Worker_co
 
 Worker_hash::~Worker_hash()
 {
-	m_serial.close();
+	asio::error_code error_code;
+	m_serial.close(error_code);
+	m_nonce_allocator->remove_consumer(m_nonce_consumer);
+}
+
+void Worker_hash::stop()
+{
+	//the pending read and write complete with operation_aborted and let go of the worker
+	std::scoped_lock<std::mutex> lck(m_mtx);
+	asio::error_code error_code;
+	m_serial.close(error_code);
 }
 
 
-void Worker_hash::set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result)
+void Worker_hash::set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result, Clock::time_point received)
 {
 	//send new block info to the device
 	std::scoped_lock<std::mutex> lck(m_mtx);
-	//cancel any outstanding serial port async read
-	m_serial.cancel();
-	
 	m_found_nonce_callback = result;
 	m_block = Block_data{ block };
 
-	m_starting_nonce = static_cast<uint64_t>(m_config.m_internal_id) << 48;
+	m_starting_nonce = m_nonce_allocator->lease(m_nonce_consumer, fpga_lease_size).m_first;
 	m_block.nNonce = m_starting_nonce;
 
 	if(nbits != 0)
@@ -60,16 +71,18 @@ void Worker_hash::set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Bloc
 		// take nbits provided by pool
 		m_pool_nbits = nbits;
 	}
+	decodeBits(m_pool_nbits != 0 ? m_pool_nbits : m_block.nBits, m_leading_zeros_required, m_target64);
 
-	send_block_to_fpga();
+	send_block_to_fpga(received);
     
 }
 
-void Worker_hash::send_block_to_fpga()
+void Worker_hash::send_block_to_fpga(std::optional<Clock::time_point> received)
 {
-	std::vector<unsigned char> headerB = m_block.GetHeaderBytes();
+	Block_data::Header_bytes header;
+	auto const header_length = m_block.WriteHeaderBytes(header);
 	//calculate midstate
-	m_skein.setMessage(headerB);
+	m_skein.setMessage(header.data(), header_length);
 	//assemble the work package
 	NexusSkein::stateType m2 = m_skein.getMessage2();
 	NexusSkein::keyType key2 = m_skein.getKey2();
@@ -79,24 +92,69 @@ void Worker_hash::send_block_to_fpga()
 
 	// Place into vector - first the key (or midstate), then the rest
 	// of the block header (block header tail.)
-	std::vector<unsigned char> fpgaWorkPackage = Midstate;
-	fpgaWorkPackage.insert(fpgaWorkPackage.end(), BlkHdrTail.begin(), BlkHdrTail.end());
+	m_next_work_package = Midstate;
+	m_next_work_package.insert(m_next_work_package.end(), BlkHdrTail.begin(), BlkHdrTail.end());
+	m_next_received = received;
+	m_next_pending = true;
 
-	//send new work package over the serial port
-	if (m_serial.is_open())
+	//send new work package over the serial port.  Asynchronous so set_block returns without waiting for the serial port
+	//and the other workers get the block right away.  A write in flight is not canceled, that could leave the fpga with
+	//part of a package.  The new package follows it.
+	if (!m_writing)
 	{
-		asio::write(m_serial, asio::buffer(fpgaWorkPackage));
+		start_write();
 	}
 
-	start_read();
+	if (!m_reading)
+	{
+		m_reading = true;
+		start_read();
+	}
+}
+
+void Worker_hash::start_write()
+{
+	if (!m_next_pending || !m_serial.is_open())
+	{
+		return;
+	}
+	m_work_package.swap(m_next_work_package);
+	m_next_pending = false;
+	m_writing = true;
+	asio::async_write(m_serial, asio::buffer(m_work_package), [self = shared_from_this(), received = m_next_received](asio::error_code const& error_code, std::size_t)
+	{
+		std::scoped_lock<std::mutex> lck(self->m_mtx);
+		self->m_writing = false;
+		if (error_code == asio::error::operation_aborted)
+		{
+			//port closed
+			return;
+		}
+		if (!error_code)
+		{
+			//the fpga starts on the new block as soon as it has the work package
+			if (received)
+			{
+				self->m_switch_latency.add(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - *received));
+			}
+		}
+		else
+		{
+			self->m_logger->error(self->m_log_leader + "Failed to send the work package. ASIO Error {} " + error_code.message(), error_code.value());
+		}
+		//a newer block came in during the write
+		self->start_write();
+	});
 }
 
 void Worker_hash::start_read()
 {	
 	// start the asynchronous read to wait for the next nonce to come across the serial port
 	try {
-		asio::async_read(m_serial, asio::buffer(m_receive_nonce_buffer), std::bind(&Worker_hash::handle_read, this,
-			std::placeholders::_1, std::placeholders::_2));
+		asio::async_read(m_serial, asio::buffer(m_receive_nonce_buffer), [self = shared_from_this()](asio::error_code const& error_code, std::size_t bytes_transferred)
+		{
+			self->handle_read(error_code, bytes_transferred);
+		});
 	}
 	catch (asio::system_error& e)
 	{
@@ -118,26 +176,27 @@ void Worker_hash::handle_read(const asio::error_code& error_code, std::size_t by
 		{
 			++m_nonce_candidates_recieved;
 			//m_logger->info(m_log_leader + "found a nonce candidate {}", nonce);
-			m_skein.setNonce(nonce);
 			//verify the difficulty
-			if (difficulty_check())
+			if (difficulty_check(nonce))
 			{
 				++m_met_difficulty_count;
-				//update the block with the nonce and call the callback function;
-				m_block.nNonce = nonce;
+				//copy the block with the nonce under the lock so a concurrent set_block cannot swap the header
+				//before submission.  handle_read already runs on the io thread so the callback is called directly.
+				Worker::Block_found_handler found_nonce_callback;
+				std::unique_ptr<Block_data> found_block;
 				{
 					std::scoped_lock<std::mutex> lck(m_mtx);
-					if (m_found_nonce_callback)
-					{
-						::asio::post([self = shared_from_this()]()
-						{
-							self->m_found_nonce_callback(self->m_config.m_internal_id, std::make_unique<Block_data>(self->m_block));
-						});
-					}
-					else
-					{
-						m_logger->debug(m_log_leader + "Miner callback function not set.");
-					}
+					found_nonce_callback = m_found_nonce_callback;
+					found_block = std::make_unique<Block_data>(m_block);
+				}
+				found_block->nNonce = nonce;
+				if (found_nonce_callback)
+				{
+					found_nonce_callback(m_config.m_internal_id, std::move(found_block));
+				}
+				else
+				{
+					m_logger->debug(m_log_leader + "Miner callback function not set.");
 				}
 			}
 		}
@@ -146,6 +205,10 @@ void Worker_hash::handle_read(const asio::error_code& error_code, std::size_t by
 	}
 	else
 	{
+		{
+			std::scoped_lock<std::mutex> lck(m_mtx);
+			m_reading = false;
+		}
 		if (error_code != asio::error::operation_aborted)  //it's normal for the async_read to be canceled. 
 		{
 			if (error_code)
@@ -171,31 +234,28 @@ void Worker_hash::update_statistics(stats::Collector& stats_collector)
 	hash_stats.m_met_difficulty_count = m_met_difficulty_count;
 	hash_stats.m_nonce_candidates_recieved = m_nonce_candidates_recieved;
 	hash_stats.m_hash_error_count = m_hash_error_count;
+	hash_stats.m_block_switch_p50_us = static_cast<std::uint32_t>(m_switch_latency.percentile(0.5).count());
+	hash_stats.m_block_switch_p99_us = static_cast<std::uint32_t>(m_switch_latency.percentile(0.99).count());
+	hash_stats.m_max_block_switch_us = static_cast<std::uint32_t>(m_switch_latency.max().count());
 
 	stats_collector.update_worker_stats(m_config.m_internal_id, hash_stats);
 }
 
-bool Worker_hash::difficulty_check()
+bool Worker_hash::difficulty_check(uint64_t nonce)
 {
 	//perform additional difficulty filtering prior to submitting the nonce 
 	
-	//leading zeros in bits required of the hash for it to pass the current difficulty.
-	int leadingZerosRequired;
-	uint64_t difficultyTest64;
-	decodeBits(m_pool_nbits != 0 ? m_pool_nbits : m_block.nBits, leadingZerosRequired, difficultyTest64);
-	m_skein.calculateHash();
-	//run keccak on the result from skein
-	NexusKeccak keccak(m_skein.getHash());
-	keccak.calculateHash();
-	uint64_t keccakHash = keccak.getResult();
+	//skein followed by keccak in one pass from the midstate.  Only the upper 64 bits of the hash are computed.
+	uint64_t keccakHash;
+	m_skein.calculateResult(&nonce, &keccakHash);
 	int hashActualLeadingZeros = 63 - findMSB(keccakHash);
-	m_logger->info(m_log_leader + "Found a candidate with {} leading zeros, {} required.", hashActualLeadingZeros, leadingZerosRequired);
+	m_logger->info(m_log_leader + "Found a candidate with {} leading zeros, {} required.", hashActualLeadingZeros, m_leading_zeros_required);
 	if (hashActualLeadingZeros > m_best_leading_zeros)
 	{
 		m_best_leading_zeros = hashActualLeadingZeros;
 	}
 	//check the hash result is less than the difficulty.  We truncate to just use the upper 64 bits for easier calculation.
-	if (keccakHash <= difficultyTest64)
+	if (keccakHash <= m_target64)
 	{
 		m_logger->info(m_log_leader + "Nonce passes difficulty check.");
 		return true;
@@ -209,7 +269,8 @@ bool Worker_hash::difficulty_check()
 			m_hash_error_count++;
 			m_logger->info(m_log_leader + "FPGA hash error detected.  Got {} leading zeros.  Expected {}.",hashActualLeadingZeros, fpga_leading_zero_threshold);
 			//something is not right.  try resending the block header to the fpga
-			send_block_to_fpga();
+			std::scoped_lock<std::mutex> lck(m_mtx);
+			send_block_to_fpga(std::nullopt);
 			
 		}
 		return false;
@@ -222,6 +283,7 @@ void Worker_hash::reset_statistics()
 	m_best_leading_zeros = 0;
 	m_met_difficulty_count = 0;
 	m_hash_error_count = 0;
+	m_switch_latency.reset();
 }
 
 }
@@ -6,6 +6,9 @@
 #include <string>
 #include <thread>
 #include "worker.hpp"
+#include "work_slot.hpp"
+#include "result_reporter.hpp"
+#include "nonce_allocator.hpp"
 #include "LLC/types/uint1024.h"
 #include <spdlog/spdlog.h>
 
@@ -23,35 +26,63 @@ public:
 
     using Worker_config = config::Worker_config;
 
-    Worker_hash(std::shared_ptr<asio::io_context> io_context, Worker_config& config);
+    Worker_hash(std::shared_ptr<asio::io_context> io_context, Worker_config& config, std::shared_ptr<Nonce_allocator> nonce_allocator);
     ~Worker_hash();
 
     // Sets a new block (nexus data type) for the miner worker. The miner worker must reset the current work.
     // When  the worker finds a new block, the BlockFoundHandler has to be called with the found BlockData
-    void set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result) override;
+    void set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result, Clock::time_point received) override;
     void update_statistics(stats::Collector& stats_collector) override;
+    void stop() override;
+    // after a found nonce until the next block
+    bool idle() const override { return m_work.idle(); }
 
 private:
 
+    //everything the mining thread needs for one block.  Never modified after it is published by set_block.
+    struct Work
+    {
+        Block_data m_block;
+        uint1024_t m_target;
+        Worker::Block_found_handler m_found_nonce_callback;
+    };
+
+    //the mining thread lives as long as the worker.  run waits for work and calls mine until it is replaced.
+    //only the mining thread talks to the device.
     void run();
+    void mine(Work const& work, std::uint64_t generation);
+    //the mining thread queues found nonces in m_results.  The io thread submits the ones that still match the current work.
+    void submit_result(Result const& result);
 
     std::shared_ptr<asio::io_context> m_io_context;
     std::shared_ptr<spdlog::logger> m_logger;
     Worker_config& m_config;
-    Worker::Block_found_handler m_found_nonce_callback;
-    std::atomic<bool> m_stop;
+    Work_slot<Work> m_work;
     std::thread m_run_thread;
 
     std::string m_log_leader;
-    Block_data m_block;
+    //found nonces that can wait for the io thread
+    Result_reporter<Work, 16> m_results;
     std::uint32_t m_pool_nbits;
-    uint1024_t m_target;
-    std::uint64_t m_hashes = 0;
+    //written by the mining thread, read and reset by update_statistics on the io thread
+    std::atomic<std::uint64_t> m_hashes{0};
     std::uint32_t m_intensity;
     std::uint32_t m_throughput;
     std::uint32_t m_threads_per_block;
-    int m_best_leading_zeros;
-    int m_met_difficulty_count;
+    //the device hashes m_throughput nonces per call.  Leases are whole calls and last about nonce_lease_duration.
+    static constexpr std::uint64_t initial_lease_calls = 64;
+    static constexpr std::chrono::milliseconds nonce_lease_duration{1000};
+    std::shared_ptr<Nonce_allocator> m_nonce_allocator;
+    std::size_t m_nonce_consumer;
+    std::atomic<int> m_best_leading_zeros;
+    std::atomic<int> m_met_difficulty_count;
+    //nonces reported by the device that don't meet the (sample) target with the reference hash
+    std::atomic<std::uint32_t> m_hash_error_count;
+    //every m_verify_interval hashes one device call runs with an easier target so it reports a nonce.
+    //The mining thread checks that nonce with the reference hash.  0 = off
+    std::uint32_t m_verify_interval;
+    //expected number of nonces below the sample target in a device call
+    static constexpr std::uint64_t sample_hits_per_call = 4;
 
 };
 }
@@ -6,6 +6,9 @@
 #include <atomic>
 #include <mutex>
 #include "worker.hpp"
+#include "work_slot.hpp"
+#include "result_reporter.hpp"
+#include "nonce_allocator.hpp"
 #include "hash/nexus_skein.hpp"
 #include "hash/nexus_keccak.hpp"
 #include <boost/multiprecision/cpp_int.hpp>
@@ -28,32 +31,50 @@ class Worker_prime : public Worker, public std::enable_shared_from_this<Worker_p
 {
 public:
 
-    Worker_prime(std::shared_ptr<asio::io_context> io_context, config::Worker_config& config);
+    Worker_prime(std::shared_ptr<asio::io_context> io_context, config::Worker_config& config,
+        std::shared_ptr<Nonce_allocator> nonce_allocator);
     ~Worker_prime() noexcept override;
 
-    void set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result) override;
+    void set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result, Clock::time_point received) override;
     void update_statistics(stats::Collector& stats_collector) override;
+    void stop() override;
 
 private:
 
+    //everything the mining thread needs for one block.  Never modified after it is published by set_block.
+    struct Work
+    {
+        Block_data m_block;
+        uint1k m_base_hash;
+        std::uint32_t m_difficulty;
+        Worker::Block_found_handler m_found_nonce_callback;
+    };
+
+    //the mining thread lives as long as the worker.  run initialises the gpu on the first block
+    //and then calls mine until the work is replaced.
     void run();
+    void mine(Work const& work, std::uint64_t generation);
+    //the mining thread queues found chains in m_results.  The io thread submits the ones that still match the current work.
+    void submit_result(Result const& result);
     double getDifficulty(uint1k p);
-    double getNetworkDifficulty();
-    bool difficulty_check(uint1k p);
+    double getNetworkDifficulty(std::uint32_t nbits);
    
     std::shared_ptr<asio::io_context> m_io_context;
     std::shared_ptr<spdlog::logger> m_logger;
     config::Worker_config& m_config;
     std::unique_ptr<Prime> m_prime_helper;
-    std::atomic<bool> m_stop;
-    std::thread m_run_thread;
-    Worker::Block_found_handler m_found_nonce_callback;
     std::unique_ptr<Sieve> m_segmented_sieve;
+    Work_slot<Work> m_work;
+    std::thread m_run_thread;
+    //only the mining thread touches the gpu
     bool m_gpu_initialized = false;
-    Block_data m_block;
-    std::mutex m_mtx;
-    std::uint64_t m_starting_nonce = 0;
+    //the gpu sieve runs from one starting offset for the whole block.  It gets one large lease per block.
+    static constexpr std::uint64_t gpu_lease_size = 1ULL << 48;
+    std::shared_ptr<Nonce_allocator> m_nonce_allocator;
+    std::size_t m_nonce_consumer;
     std::string m_log_leader;
+    //found chains that can wait for the io thread
+    Result_reporter<Work, 16> m_results;
 
     std::uint32_t m_primes{ 0 };
     std::uint32_t m_chains{ 0 };
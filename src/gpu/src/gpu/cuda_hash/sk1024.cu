@@ -557,7 +557,8 @@ __global__ void  sk1024_gpu_hash(int threads, uint64_t startNonce, uint64_t* res
 	}
 }
 
-__host__ uint64_t sk1024_cpu_hash(uint32_t thr_id, uint32_t threads, uint64_t startNonce, uint32_t threadsperblock)
+//returns the nonce with the lowest hash at or below the target and the upper 64 bits of its hash in lowerHash
+__host__ uint64_t sk1024_cpu_hash(uint32_t thr_id, uint32_t threads, uint64_t startNonce, uint32_t threadsperblock, uint64_t& lowerHash)
 {
 	uint64_t result = 0xFFFFFFFFFFFFFFFF;
 	cudaMemset(d_SKNonce[thr_id], 0xFF, sizeof(uint64_t));
@@ -570,6 +571,7 @@ __host__ uint64_t sk1024_cpu_hash(uint32_t thr_id, uint32_t threads, uint64_t st
 
 	sk1024_gpu_hash << <grid, block >> > (threads, startNonce, d_SKNonce[thr_id], d_SKLowerHash[thr_id]);
 	cudaMemcpy(h_sknonce[thr_id], d_SKNonce[thr_id], sizeof(uint64_t), cudaMemcpyDeviceToHost);
+	cudaMemcpy(&lowerHash, d_SKLowerHash[thr_id], sizeof(uint64_t), cudaMemcpyDeviceToHost);
 
 	result = *h_sknonce[thr_id];
 
@@ -759,40 +761,20 @@ extern bool cuda_sk1024_hash(
 	const uint64_t first_nonce = TheNonce;
 	const uint64_t Htarg = ptarget[15];
 
+	uint64_t lowerHash = 0xffffffffffffffff;
 	uint64_t foundNonce = sk1024_cpu_hash(thr_id,
 		throughput,
 		((uint64_t*)TheData)[26],
-		threadsPerBlock);
+		threadsPerBlock,
+		lowerHash);
 
-	if (foundNonce != 0xffffffffffffffff)
+	//the caller checks the nonce with the reference hash (worker_hash.cpp)
+	if (foundNonce != 0xffffffffffffffff && lowerHash <= Htarg)
 	{
 		((uint64_t*)TheData)[26] = foundNonce;
-		uint1024_t skein;
-		Skein1024_Ctxt_t ctx;
-		Skein1024_Init(&ctx, 1024);
-		Skein1024_Update(&ctx, (uint8_t*)TheData, 216);
-		Skein1024_Final(&ctx, (uint8_t*)&skein);
-
-		uint64_t keccak[16];
-		Keccak_HashInstance ctx_keccak;
-		Keccak_HashInitialize(&ctx_keccak, 576, 1024, 1024, 0x05);
-		Keccak_HashUpdate(&ctx_keccak, (uint8_t*)&skein, 1024);
-		Keccak_HashFinal(&ctx_keccak, (uint8_t*)&keccak);
-
-		if (keccak[15] <= Htarg)
-		{
-			TheNonce = foundNonce; //return the nonce
-			*hashes_done = foundNonce - first_nonce + 1;
-			return true;
-		}
-		else
-		{
-			std::cout << "GPU # " << thr_id << ": result for nonce " <<  foundNonce << " does not validate on CPU!" << std::endl;
-
-			std::cout << std::hex << std::setw(16) << std::setfill('0') << keccak[15] << " > " << std::setw(16) << std::setfill('0') << Htarg << std::endl;
-		}
-
-
+		TheNonce = foundNonce; //return the nonce
+		*hashes_done = foundNonce - first_nonce + 1;
+		return true;
 	}
 
 	((uint64_t*)TheData)[26] += throughput;
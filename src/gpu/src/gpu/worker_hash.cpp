@@ -4,6 +4,7 @@
 #include "block.hpp"
 #include <asio/io_context.hpp>
 #include <asio/post.hpp>
+#include <algorithm>
 #include "cuda_hash/util.h"
 #include "cuda_hash/sk1024.h"
 #include "LLC/hash/SK.h"
@@ -16,17 +17,19 @@ namespace nexusminer
 namespace gpu
 {
 
-Worker_hash::Worker_hash(std::shared_ptr<asio::io_context> io_context, Worker_config& config)
+Worker_hash::Worker_hash(std::shared_ptr<asio::io_context> io_context, Worker_config& config, std::shared_ptr<Nonce_allocator> nonce_allocator)
 : m_io_context{std::move(io_context)}
 , m_logger{spdlog::get("logger")}
 , m_config{config}
-, m_found_nonce_callback{}
-, m_stop{true}
 , m_log_leader{ "GPU Worker " + m_config.m_id + ": " }
+, m_results{ m_work, m_logger, m_log_leader, "nonce" }
 , m_pool_nbits{0}
 , m_threads_per_block{896}
+, m_nonce_allocator{std::move(nonce_allocator)}
 , m_best_leading_zeros{0}
 , m_met_difficulty_count{0}
+, m_hash_error_count{0}
+, m_verify_interval{std::get<config::Worker_config_gpu>(m_config.m_worker_mode).m_verify_interval}
 {	
     auto& worker_config_gpu = std::get<config::Worker_config_gpu>(m_config.m_worker_mode);
     cuda_init(worker_config_gpu.m_device);
@@ -40,12 +43,20 @@ Worker_hash::Worker_hash(std::shared_ptr<asio::io_context> io_context, Worker_co
 
     // Calcluate the throughput for the cuda hash mining
     m_throughput = 256 * m_threads_per_block * m_intensity;
+    m_nonce_consumer = m_nonce_allocator->add_consumer(m_throughput, initial_lease_calls * m_throughput, nonce_lease_duration);
+    if (m_verify_interval != 0)
+    {
+        m_logger->info(m_log_leader + "Verifying 1 nonce in about {} hashes with the reference hash.", m_verify_interval);
+    }
+
+    //the thread waits for the first block
+    m_run_thread = std::thread(&Worker_hash::run, this);
 }
 
 Worker_hash::~Worker_hash() 
 { 
     //make sure the run thread exits the loop
-    m_stop = true;
+    m_work.stop();
     if (m_run_thread.joinable())
     {
         m_run_thread.join();
@@ -56,35 +67,31 @@ Worker_hash::~Worker_hash()
 
     // Free the GPU device memory and reset them
     cuda_free(m_config.m_internal_id);
+
+    m_nonce_allocator->remove_consumer(m_nonce_consumer);
 }
 
-void Worker_hash::set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result)
+void Worker_hash::stop()
 {
-    //stop the existing mining loop if it is running
-    m_stop = true;
-    if (m_run_thread.joinable())
-    {
-        m_run_thread.join();
-    }
-
+    m_work.stop();
+}
 
-    m_found_nonce_callback = result;
-    m_block = Block_data{block};
+void Worker_hash::set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result, Clock::time_point received)
+{
+    auto work = std::make_shared<Work>();
+    work->m_found_nonce_callback = result;
+    work->m_block = Block_data{block};
     if (nbits != 0)
     {
         // take nbits provided by pool
         m_pool_nbits = nbits;
     }
 
-    // Set the block for this device
-    cuda_sk1024_setBlock(&m_block.nVersion, m_block.nHeight);
-
-
     /* Get the target difficulty. */
-    auto const nbits_cuda = m_pool_nbits != 0 ? m_pool_nbits : m_block.nBits;
+    auto const nbits_cuda = m_pool_nbits != 0 ? m_pool_nbits : work->m_block.nBits;
 
-    double mainnet_difficulty = TAO::Ledger::GetDifficulty(m_block.nBits, m_block.nChannel);
-    double pool_difficulty = TAO::Ledger::GetDifficulty(m_pool_nbits, m_block.nChannel);
+    double mainnet_difficulty = TAO::Ledger::GetDifficulty(work->m_block.nBits, work->m_block.nChannel);
+    double pool_difficulty = TAO::Ledger::GetDifficulty(m_pool_nbits, work->m_block.nChannel);
     if (m_pool_nbits != 0)
         m_logger->debug("Leading zeros required mainnet:{}  pool:{}", log2(mainnet_difficulty)+34, log2(pool_difficulty)+34);
     else
@@ -93,77 +100,161 @@ void Worker_hash::set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Bloc
     /* Get the target difficulty. */
     LLC::CBigNum target;
     target.SetCompact(nbits_cuda);
-    m_target = target.getuint1024();
-
-    // Set the target hash on this device for the difficulty.
-    cuda_sk1024_set_Target((uint64_t*)m_target.begin());
+    work->m_target = target.getuint1024();
 
-    //restart the mining loop
-    m_stop = false;
-    m_run_thread = std::thread(&Worker_hash::run, this);
+    //hand the work to the mining thread.  It switches after the current device call so there is nothing to wait for.
+    m_work.publish(std::move(work), received);
 }
 
 void Worker_hash::run()
 {
-    while (!m_stop)
+    std::uint64_t generation = 0;
+    while (auto work = m_work.wait(generation))
     {
+        mine(*work, generation);
+    }
+}
+
+void Worker_hash::mine(Work const& work, std::uint64_t generation)
+{
+    Block_data block = work.m_block;
+    //the device starts at the first nonce of the lease and moves on by m_throughput per call
+    m_nonce_allocator->new_work(m_nonce_consumer);
+    auto lease = m_nonce_allocator->lease(m_nonce_consumer);
+    block.nNonce = lease.m_first;
+
+    // Set the block for this device
+    cuda_sk1024_setBlock(&block.nVersion, block.nHeight);
+
+    // Set the target hash on this device for the difficulty.
+    cuda_sk1024_set_Target((uint64_t*)work.m_target.begin());
+
+    //sampling for the kernel check.  The sample target is met by about sample_hits_per_call nonces per device call.
+    //The device keeps the lowest hash below its target with a plain compare and write, so with several hits in one call the
+    //reported nonce can come with the hash of another hit.  Every hit writes its own nonce though, the reported one meets the
+    //sample target.  So a sample is checked with the reference hash of the reported nonce and that hash decides if it is
+    //a find.  A nonce meeting the real target can only be lost in a sampled call if it races with another hit.
+    uint1024_t sample_target = work.m_target;
+    std::uint64_t const sample_target64 = std::max<std::uint64_t>(work.m_target.Get64(15), ~0ULL / m_throughput * sample_hits_per_call);
+    reinterpret_cast<uint64_t*>(sample_target.begin())[15] = sample_target64;
+    std::uint64_t hashes_to_sample = m_verify_interval;
+
+    m_work.mark_started(generation);
+    while (!m_work.changed(generation))
+    {
+        if (block.nNonce >= lease.end())
+        {
+            lease = m_nonce_allocator->lease(m_nonce_consumer);
+            block.nNonce = lease.m_first;
+        }
+        bool const sample = m_verify_interval != 0 && hashes_to_sample == 0;
+        if (sample)
+        {
+            cuda_sk1024_set_Target((uint64_t*)sample_target.begin());
+        }
+        std::uint64_t const first_nonce = block.nNonce;
         std::uint64_t hashes = 0;
+        uint1024_t hash_proof;
 
         // Do hashing on a CUDA device
         bool found = cuda_sk1024_hash(
             m_config.m_internal_id,
-            reinterpret_cast<uint32_t*>(&m_block.nVersion),
-            m_target,
-            m_block.nNonce,
+            reinterpret_cast<uint32_t*>(&block.nVersion),
+            sample ? sample_target : work.m_target,
+            block.nNonce,
             &hashes,
             m_throughput,
             m_threads_per_block,
-            m_block.nHeight);
+            block.nHeight);
+
+        if (sample)
+        {
+            cuda_sk1024_set_Target((uint64_t*)work.m_target.begin());
+            if (found)
+            {
+                //keep sampling every call until the device reports a nonce
+                hashes_to_sample = m_verify_interval;
+                hash_proof = LLC::SK1024(BEGIN(block.nVersion), END(block.nNonce));
+                if (hash_proof.Get64(15) > sample_target64)
+                {
+                    ++m_hash_error_count;
+                    m_logger->error(m_log_leader + "Sampled nonce {} from the device does not meet the sample target.", block.nNonce);
+                }
+                found = hash_proof <= work.m_target;
+                if (!found)
+                {
+                    //the device hashed the whole call
+                    block.nNonce = first_nonce + m_throughput;
+                    hashes = m_throughput;
+                }
+            }
+        }
+        else if (m_verify_interval != 0)
+        {
+            hashes_to_sample -= std::min(hashes_to_sample, hashes);
+        }
 
-        m_hashes += hashes;
+        m_hashes.fetch_add(hashes, std::memory_order_relaxed);
 
         // If a nonce with the right diffulty was found submit block.
-        if (found && !m_stop.load())
+        if (found && !m_work.changed(generation))
         {
+            // Check the nonce from the device against the reference hash before submitting it (a sample has it already)
+            if (!sample)
+            {
+                hash_proof = LLC::SK1024(BEGIN(block.nVersion), END(block.nNonce));
+            }
+            if (hash_proof > work.m_target)
+            {
+                ++m_hash_error_count;
+                m_logger->error(m_log_leader + "Nonce {} from the device does not meet the target.", block.nNonce);
+                block.nNonce = first_nonce + m_throughput;
+                continue;
+            }
             ++m_met_difficulty_count;
             // Calculate the number of leading zero-bits
-            uint1024_t hash_proof = LLC::SK1024(BEGIN(m_block.nVersion), END(m_block.nNonce));
-            std::uint32_t leading_zeros = 1024 - hash_proof.BitCount();
-            if (leading_zeros > m_best_leading_zeros)
+            int const leading_zeros = 1024 - hash_proof.BitCount();
+            if (leading_zeros > m_best_leading_zeros.load(std::memory_order_relaxed))
             {
-                m_best_leading_zeros = leading_zeros;
+                m_best_leading_zeros.store(leading_zeros, std::memory_order_relaxed);
             }
            // debug::log(0, "[MASTER] Found Hash Block ");
            // block.print();
 
-            if (m_found_nonce_callback)
-            {
-                ::asio::post([self = shared_from_this()]()
-                {
-                    self->m_found_nonce_callback(self->m_config.m_internal_id, std::make_unique<Block_data>(self->m_block));
-                });
-            }
-            else
-            {
-                m_logger->debug(m_log_leader + "Miner callback function not set.");
-            }
+            submit_result({ m_config.m_internal_id, generation, block.nNonce, static_cast<double>(leading_zeros) });
 
-            m_stop = true;
+            //idle until the next block
+            return;
         }
 
     }
 }
 
+void Worker_hash::submit_result(Result const& result)
+{
+    m_results.submit(result, [this]()
+    {
+        //keeps the worker alive until the drain ran
+        ::asio::post(*m_io_context, [self = shared_from_this()]()
+        {
+            self->m_results.drain();
+        });
+    });
+}
 
 void Worker_hash::update_statistics(stats::Collector& stats_collector)
 {
     auto hash_stats = std::get<stats::Hash>(stats_collector.get_worker_stats(m_config.m_internal_id));
-    hash_stats.m_hash_count += m_hashes;
-    hash_stats.m_best_leading_zeros = m_best_leading_zeros;
-    hash_stats.m_met_difficulty_count = m_met_difficulty_count;
+    hash_stats.m_hash_count += m_hashes.exchange(0, std::memory_order_relaxed);
+    hash_stats.m_best_leading_zeros = m_best_leading_zeros.load(std::memory_order_relaxed);
+    hash_stats.m_met_difficulty_count = m_met_difficulty_count.load(std::memory_order_relaxed);
+    hash_stats.m_hash_error_count = m_hash_error_count.load(std::memory_order_relaxed);
+    auto const switch_latency = m_work.get_switch_latency();
+    hash_stats.m_block_switch_p50_us = static_cast<std::uint32_t>(switch_latency.percentile(0.5).count());
+    hash_stats.m_block_switch_p99_us = static_cast<std::uint32_t>(switch_latency.percentile(0.99).count());
+    hash_stats.m_max_block_switch_us = static_cast<std::uint32_t>(switch_latency.max().count());
 
     stats_collector.update_worker_stats(m_config.m_internal_id, hash_stats);
-    m_hashes = 0;
 }
 
 }
@@ -14,19 +14,21 @@ namespace nexusminer
 {
 namespace gpu
 {
-Worker_prime::Worker_prime(std::shared_ptr<asio::io_context> io_context, config::Worker_config& config)
+Worker_prime::Worker_prime(std::shared_ptr<asio::io_context> io_context, config::Worker_config& config,
+	std::shared_ptr<Nonce_allocator> nonce_allocator)
 	: m_io_context{ std::move(io_context) }
 	, m_logger{ spdlog::get("logger") }
 	, m_config{ config }
 	, m_prime_helper{std::make_unique<Prime>()}
 	, m_segmented_sieve{std::make_unique<Sieve>()}
-	, m_stop{ true }
+	, m_nonce_allocator{ std::move(nonce_allocator) }
+	, m_nonce_consumer{ m_nonce_allocator->add_consumer(1, gpu_lease_size, std::chrono::milliseconds{0}) }
 	, m_log_leader{ "GPU Worker " + m_config.m_id + ": " }
+	, m_results{ m_work, m_logger, m_log_leader, "chain" }
 	, m_primes{ 0 }
 	, m_chains{ 0 }
 	, m_difficulty{ 0 }
 	, m_pool_nbits{ 0 }
-	, m_gpu_initialized{false}
 {
 	
 	auto& worker_config_gpu = std::get<config::Worker_config_gpu>(m_config.m_worker_mode);
@@ -37,13 +39,14 @@ Worker_prime::Worker_prime(std::shared_ptr<asio::io_context> io_context, config:
 	m_segmented_sieve->generate_sieving_primes();
 	m_segmented_sieve->generate_small_prime_tables();
 	m_segmented_sieve->generate_trial_divisors();
-
+	//the mining thread waits for the first block
+	m_run_thread = std::thread(&Worker_prime::run, this);
 }
 
 Worker_prime::~Worker_prime() noexcept
 {
 	//make sure the run thread exits the loop
-	m_stop = true;
+	m_work.stop();
 	if (m_run_thread.joinable())
 		m_run_thread.join();
 	//free gpu memory
@@ -52,73 +55,80 @@ Worker_prime::~Worker_prime() noexcept
 		m_segmented_sieve->gpu_sieve_free();
 		m_segmented_sieve->gpu_fermat_free();
 	}
+	m_nonce_allocator->remove_consumer(m_nonce_consumer);
 }
 
-void Worker_prime::set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result)
+void Worker_prime::stop()
 {
-	//stop the existing mining loop if it is running
-	m_stop = true;
-	if (m_run_thread.joinable())
-	{
-		m_run_thread.join();
-	}
+	m_work.stop();
+}
 
+void Worker_prime::set_block(LLP::CBlock block, std::uint32_t nbits, Worker::Block_found_handler result, Clock::time_point received)
+{
+	auto work = std::make_shared<Work>();
+	work->m_found_nonce_callback = result;
+	work->m_block = Block_data{ block };
+	if (nbits != 0)	// take nBits provided from pool
 	{
-		std::scoped_lock<std::mutex> lck(m_mtx);
-		m_found_nonce_callback = result;
-		m_block = Block_data{ block };
-		if (nbits != 0)	// take nBits provided from pool
-		{
-			m_pool_nbits = nbits;
-		}
+		m_pool_nbits = nbits;
+	}
 
-		m_difficulty = m_pool_nbits != 0 ? m_pool_nbits : m_block.nBits;
-		bool excludeNonce = true;  //prime block hash excludes the nonce
-		std::vector<unsigned char> headerB = m_block.GetHeaderBytes(excludeNonce);
-		//calculate the block hash
-		NexusSkein skein;
-		skein.setMessage(headerB);
-		skein.calculateHash();
-		NexusSkein::stateType hash = skein.getHash();
+	m_difficulty = m_pool_nbits != 0 ? m_pool_nbits : work->m_block.nBits;
+	work->m_difficulty = m_difficulty;
+	bool excludeNonce = true;  //prime block hash excludes the nonce
+	Block_data::Header_bytes header;
+	auto const header_length = work->m_block.WriteHeaderBytes(header, excludeNonce);
+	//calculate the block hash
+	NexusSkein skein;
+	skein.setMessage(header.data(), header_length);
+	skein.calculateHash();
+	NexusSkein::stateType hash = skein.getHash();
 
-		//keccak
-		NexusKeccak keccak(hash);
-		keccak.calculateHash();
-		NexusKeccak::k_1024 keccakFullHash_i = keccak.getHashResult();
-		keccakFullHash_i.isBigInt = true;
-		uint1k keccakFullHash("0x" + keccakFullHash_i.toHexString(true));
-		m_base_hash = keccakFullHash;
-		//Now we have the hash of the block header.  We use this to feed the miner. 
+	//keccak
+	NexusKeccak keccak(hash);
+	keccak.calculateHash();
+	NexusKeccak::k_1024 keccakFullHash_i = keccak.getHashResult();
+	keccakFullHash_i.isBigInt = true;
+	uint1k keccakFullHash("0x" + keccakFullHash_i.toHexString(true));
+	work->m_base_hash = keccakFullHash;
+	//Now we have the hash of the block header.  We use this to feed the miner. 
 
-		//set the starting nonce for each worker to something different that won't overlap with the others
-		m_starting_nonce = static_cast<uint64_t>(m_config.m_internal_id) << 48;
-		m_nonce = m_starting_nonce;
+	//hand the work to the mining thread.  It switches after the current sieve stage so there is nothing to wait for.
+	m_work.publish(std::move(work), received);
+}
 
-		//set the sieve start range
-		uint1k startprime = m_base_hash + m_nonce;
-		m_segmented_sieve->set_sieve_start(startprime);
-		//update the starting nonce to reflect the actual sieve start used
-		m_nonce = static_cast<uint64_t>(m_segmented_sieve->get_sieve_start() - m_base_hash);
-		//m_logger->debug("starting nonce: {}", m_nonce);
-		//clear out any old chains from the last block
-		m_segmented_sieve->clear_chains();
-	}
-	//restart the mining loop
-	m_stop = false;
-	//The first time prior to running allocate memory on the gpu
-	
-	if (!m_gpu_initialized)
+void Worker_prime::run()
+{
+	std::uint64_t generation = 0;
+	while (auto work = m_work.wait(generation))
 	{
-		auto& worker_config_gpu = std::get<config::Worker_config_gpu>(m_config.m_worker_mode);
-		m_segmented_sieve->gpu_sieve_load(worker_config_gpu.m_device);
-		m_segmented_sieve->gpu_fermat_test_init(worker_config_gpu.m_device);
-		m_gpu_initialized = true;
+		//The first time prior to running allocate memory on the gpu
+		if (!m_gpu_initialized)
+		{
+			auto& worker_config_gpu = std::get<config::Worker_config_gpu>(m_config.m_worker_mode);
+			m_segmented_sieve->gpu_sieve_load(worker_config_gpu.m_device);
+			m_segmented_sieve->gpu_fermat_test_init(worker_config_gpu.m_device);
+			m_gpu_initialized = true;
+		}
+		mine(*work, generation);
 	}
-	m_run_thread = std::thread(&Worker_prime::run, this);
 }
 
-void Worker_prime::run()
+void Worker_prime::mine(Work const& work, std::uint64_t generation)
 {
+	Block_data block = work.m_block;
+	m_base_hash = work.m_base_hash;
+	//lease the sieve offsets for this block so they won't overlap with the other workers
+	m_nonce = m_nonce_allocator->lease(m_nonce_consumer, gpu_lease_size).m_first;
+
+	//set the sieve start range
+	uint1k startprime = m_base_hash + m_nonce;
+	m_segmented_sieve->set_sieve_start(startprime);
+	//update the starting nonce to reflect the actual sieve start used
+	m_nonce = static_cast<uint64_t>(m_segmented_sieve->get_sieve_start() - m_base_hash);
+	//m_logger->debug("starting nonce: {}", m_nonce);
+	//clear out any old chains from the last block
+	m_segmented_sieve->clear_chains();
 	m_segmented_sieve->calculate_starting_multiples();
 	//copy starting multiples to the sieve
 	m_segmented_sieve->gpu_sieve_init();
@@ -142,7 +152,8 @@ void Worker_prime::run()
 	bool debug = m_logger->level() <= spdlog::level::level_enum::debug;
 	auto start = std::chrono::steady_clock::now();
 	auto interval_start = std::chrono::steady_clock::now();
-	while (!m_stop)
+	m_work.mark_started(generation);
+	while (!m_work.changed(generation))
 	{
 		m_range_searched += sieve_batch_range;
 		range_searched_this_cycle += sieve_batch_range;
@@ -156,14 +167,14 @@ void Worker_prime::run()
 		auto sieve_stop = std::chrono::steady_clock::now();
 		auto sieve_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(sieve_stop - sieve_start);
 		sieving_ms += sieve_elapsed.count();
-		if (m_stop) break;
+		if (m_work.changed(generation)) break;
 		auto find_chains_start = std::chrono::steady_clock::now();
 		m_segmented_sieve->find_chains();
 		if (debug) m_segmented_sieve->gpu_sieve_synchronize();
 		auto find_chains_stop = std::chrono::steady_clock::now();
 		auto find_chains_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(find_chains_stop - find_chains_start);
 		find_chains_ms += find_chains_elapsed.count();
-		if (m_stop) break;
+		if (m_work.changed(generation)) break;
 		//m_segmented_sieve->do_chain_trial_division_check();
 		auto test_chains_start = std::chrono::steady_clock::now();
 		m_segmented_sieve->gpu_run_fermat_chain_test();
@@ -171,44 +182,34 @@ void Worker_prime::run()
 		auto test_chains_stop = std::chrono::steady_clock::now();
 		auto test_chains_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(test_chains_stop - test_chains_start);
 		test_chains_ms += test_chains_elapsed.count();
-		if (m_stop) break;
+		if (m_work.changed(generation)) break;
 		auto clean_chains_start = std::chrono::steady_clock::now();
 		m_segmented_sieve->gpu_clean_chains();
 		if (debug) m_segmented_sieve->gpu_sieve_synchronize();
 		auto clean_chains_stop = std::chrono::steady_clock::now();
 		auto clean_chains_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(clean_chains_stop - clean_chains_start);
 		clean_chains_ms += clean_chains_elapsed.count();
-		if (m_stop) break;
+		if (m_work.changed(generation)) break;
 		//check for winners
 		m_segmented_sieve->get_long_chains();
 		//check difficulty of any chains that passed through the filter
 		for (auto x : m_segmented_sieve->m_long_chain_starts)
 		{
-			m_block.nNonce = m_nonce + x;
-			uint1k chain_start = m_base_hash + m_block.nNonce;
+			block.nNonce = m_nonce + x;
+			uint1k chain_start = m_base_hash + block.nNonce;
 			double difficulty = getDifficulty(chain_start);
 			m_segmented_sieve->m_best_chain = std::max(difficulty, m_segmented_sieve->m_best_chain);
-			m_logger->info("Actual difficulty {} required {}", difficulty, getNetworkDifficulty());
-			if (difficulty_check(chain_start))
+			m_logger->info("Actual difficulty {} required {}", difficulty, getNetworkDifficulty(work.m_difficulty));
+			if (difficulty >= getNetworkDifficulty(work.m_difficulty))
 			{
 				//we found a valid chain.  submit it. 
-				if (m_found_nonce_callback)
-				{
-					::asio::post([self = shared_from_this()]()
-					{
-						self->m_found_nonce_callback(self->m_config.m_internal_id, std::make_unique<Block_data>(self->m_block));
-					});
-				}
-				else
-				{
-					m_logger->debug(m_log_leader + "Miner callback function not set.");
-				}
+				submit_result({ m_config.m_internal_id, generation, block.nNonce, difficulty });
 			}
 		}
 		m_segmented_sieve->gpu_get_stats();
 		m_segmented_sieve->m_long_chain_starts = {};
 		low += sieve_batch_range;
-		if (m_stop) break;
+		if (m_work.changed(generation)) break;
 
 		//debug
 		auto end = std::chrono::steady_clock::now();
@@ -246,6 +247,18 @@ void Worker_prime::run()
 	
 }
 
+void Worker_prime::submit_result(Result const& result)
+{
+	m_results.submit(result, [this]()
+	{
+		//keeps the worker alive until the drain ran
+		::asio::post(*m_io_context, [self = shared_from_this()]()
+		{
+			self->m_results.drain();
+		});
+	});
+}
+
 double Worker_prime::getDifficulty(uint1k p)
 {
 	std::vector<unsigned int> offsets_to_test;
@@ -254,14 +267,9 @@ double Worker_prime::getDifficulty(uint1k p)
 	return difficulty;
 }
 
-double Worker_prime::getNetworkDifficulty()
-{
-	return m_difficulty / 10000000.0;
-}
-
-bool Worker_prime::difficulty_check(uint1k p)
+double Worker_prime::getNetworkDifficulty(std::uint32_t nbits)
 {
-	return getDifficulty(p) >= getNetworkDifficulty();
+	return nbits / 10000000.0;
 }
 
 
@@ -284,6 +292,10 @@ void Worker_prime::update_statistics(stats::Collector& stats_collector)
 	prime_stats.m_chain_histogram = m_segmented_sieve->m_chain_histogram;
 	prime_stats.m_range_searched = m_range_searched;
 	prime_stats.m_most_difficult_chain = m_segmented_sieve->m_best_chain;
+	auto const switch_latency = m_work.get_switch_latency();
+	prime_stats.m_block_switch_p50_us = static_cast<std::uint32_t>(switch_latency.percentile(0.5).count());
+	prime_stats.m_block_switch_p99_us = static_cast<std::uint32_t>(switch_latency.percentile(0.99).count());
+	prime_stats.m_max_block_switch_us = static_cast<std::uint32_t>(switch_latency.max().count());
 	stats_collector.update_worker_stats(m_config.m_internal_id, prime_stats);
 
 	m_primes = 0;
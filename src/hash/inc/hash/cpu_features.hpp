@@ -0,0 +1,19 @@
+#ifndef NEXUS_CPU_FEATURES_HPP
+#define NEXUS_CPU_FEATURES_HPP
+//runtime detection of the simd instruction sets used by the multi lane hash kernels
+#include <cstdint>
+
+struct CpuFeatures
+{
+    bool sse2 = false;
+    bool avx2 = false;
+    bool avx512 = false;  //AVX-512 Foundation
+};
+
+//cpuid of the leaf and subleaf into eax, ebx, ecx, edx.  false if the leaf is not supported or this is not an x86 cpu
+bool cpuid(uint32_t leaf, uint32_t subleaf, uint32_t (&regs)[4]);
+
+//query the cpu (and os support for the extended register state) once and cache the result
+const CpuFeatures& getCpuFeatures();
+
+#endif
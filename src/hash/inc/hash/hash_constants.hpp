@@ -0,0 +1,61 @@
+#ifndef NEXUS_HASH_CONSTANTS_HPP
+#define NEXUS_HASH_CONSTANTS_HPP
+//Constants of the nexus skein and keccak.  Shared by NexusSkein, NexusKeccak and the multi lane kernels.
+//The kernels are compiled with SSE2/AVX2/AVX-512 flags.  Any inline function they include could be emitted with those
+//instructions and picked by the linker for the scalar callers, so this header holds data only and includes nothing else.
+
+#include <cstdint>
+
+struct SkeinConstants
+{
+    // special key constant in threefish. This is the original constant. It was changed in skein version 1.3
+    static constexpr uint64_t C240 = 0x5555555555555555;
+    static constexpr int numRounds = 80;  //rounds within threefish
+    static constexpr int numWords = 16;  //number of 64 bit words (1024 bits / 64)
+    static constexpr int subkeyCount = numRounds / 4 + 1;  //21 subkeys
+    //word permutation constants
+    static constexpr int permuteIndices[numWords] = { 0, 9, 2, 13, 6, 11, 4, 15, 10, 7, 12, 3, 14, 5, 8, 1 };
+    //The original mix function rotation constants.These changed between version 1.1 and 1.2 of Skein
+    static constexpr int R[8][8] = { {55, 43, 37, 40, 16, 22, 38, 12},{25, 25, 46, 13, 14, 13, 52, 57},
+        {33, 8, 18, 57, 21, 12, 32, 54},{34, 43, 25, 60, 44, 9, 59, 34},
+        {28, 7, 47, 48, 51, 9, 35, 41},{17, 6, 18, 25, 43, 42, 40, 15},
+        {58, 7, 32, 45, 19, 18, 2, 56},{47, 49, 27, 58, 37, 48, 53, 56} };
+    //number of nonces hashed in parallel by the multi lane (SIMD) versions of calculateHash
+    static constexpr int lanesSSE2 = 2;
+    static constexpr int lanesAVX2 = 4;
+    static constexpr int lanesAVX512 = 8;
+
+    //a nonce found by hashRange and the top 64 bits of its nexus hash
+    struct Candidate
+    {
+        uint64_t nonce;
+        uint64_t result;
+    };
+};
+
+struct KeccakConstants
+{
+    static constexpr int numPlane = 5;
+    static constexpr int numSheet = 5;
+    static constexpr int messageLength = 9;
+    static constexpr int numRounds = 24;
+    static constexpr uint64_t NXS_SUFFIX_1 = 0x5;
+    static constexpr uint64_t NXS_SUFFIX_2 = 0x8000000000000000;
+    static constexpr uint64_t round_const[numRounds] =
+       {0x0000000000000001, 0x0000000000008082, 0x800000000000808A,0x8000000080008000,
+        0x000000000000808B, 0x0000000080000001, 0x8000000080008081, 0x8000000000008009,
+        0x000000000000008A, 0x0000000000000088, 0x0000000080008009, 0x000000008000000A,
+        0x000000008000808B, 0x800000000000008B, 0x8000000000008089, 0x8000000000008003,
+        0x8000000000008002, 0x8000000000000080, 0x000000000000800A, 0x800000008000000A,
+        0x8000000080008081, 0x8000000000008080, 0x0000000080000001, 0x8000000080008008 };
+
+    //rotation constants
+    static constexpr int r[numSheet][numPlane] =
+        { {0, 36, 3, 41, 18},
+        {1, 44, 10, 45, 2},
+        {62, 6, 43, 15, 61},
+        {28, 55, 25, 21, 56},
+        {27, 20, 39, 8, 14} };
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef NEXUS_HASH_KERNELS_HPP
+#define NEXUS_HASH_KERNELS_HPP
+//Registry of the mining kernels for the nexus hash.
+//A kernel runs skein + keccak for a batch of nonces and returns the top 64 bits of each hash.
+
+#include "hash/nexus_skein.hpp"
+#include <string>
+#include <vector>
+
+struct HashKernel
+{
+    std::string name;
+    //number of nonces per call
+    int lanes;
+    //the cpu supports the instruction set
+    bool supported;
+    void (NexusSkein::*calculateResult)(const uint64_t* nonces, uint64_t* results) const;
+    //NexusSkein::hashRange with this instruction set
+    void (NexusSkein::*hashRange)(uint64_t firstNonce, uint64_t count, uint64_t threshold, std::vector<NexusSkein::Candidate>& candidates) const;
+};
+
+//every kernel in this build ordered from slowest to fastest
+const std::vector<HashKernel>& getHashKernels();
+//nullptr if there is no kernel with this name
+const HashKernel* findHashKernel(const std::string& name);
+
+#endif
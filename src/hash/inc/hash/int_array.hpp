@@ -33,18 +33,17 @@ public:
     void fromBytes(const std::vector<unsigned char>& b)
     //the input byte vector is little endian
     {
-        int numWords = SIZE;
-        int arrayIndex;
-        int byteCount = intSize();
+        fromBytes(b.data(), b.size());
+    }
+
+    void fromBytes(const unsigned char* b, size_t length)
+    //length little endian bytes.  Words past the end of the input are zero.
+    {
         intArray = { 0 };
-        
-        //iterate through all the bytes.  
-        for (auto i = 0; i / byteCount - 1 < numWords && i < b.size(); i++)
+        for (size_t i = 0; i < length && i < SIZE * sizeof(T); i++)
         {
-            arrayIndex = i / byteCount;
-            intArray[arrayIndex] += (static_cast<T>(b[i]) << i * 8);
+            intArray[i / sizeof(T)] |= static_cast<T>(b[i]) << (i % sizeof(T)) * 8;
         }
-
     }
 
     void fromHexString(std::string hexString, bool bigEndian=false)
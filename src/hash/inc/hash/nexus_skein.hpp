@@ -14,6 +14,7 @@
 // Threefish2 takes the output of threefish1 to make it's key.  Key2 is therefore also fixed per block and can be computed once for each new block in software.
 // The message for threefish2 (aka message2) is the last half of the nexus header padded with zeros. The nonce is included in this message.
 // Most of message2 is fixed per block.The only part that changes is the 64 bit nonce section.
+// The first rounds of threefish2 only partly depend on the nonce. The nonce independent part (midstate2) is also computed once per block.
 // Message3 is fixed at all zeros. Key3 is a function of threefish2 and message2.
 // We will send the hardware accelerator these values per block as inputs :
 // Key2 as 17 unsigned 64 bit numbers
@@ -24,18 +25,17 @@
 #define NEXUS_SKEIN_HPP
 
 #include "int_array.hpp"
+#include "hash_constants.hpp"
+#include <vector>
 
-class NexusSkein
+//the threefish constants are shared with the multi lane kernels (hash_constants.hpp)
+class NexusSkein : public SkeinConstants
 {
 public:
     NexusSkein();
     NexusSkein(const std::vector<unsigned char>& m);
+
 private:
-    // special key constant in threefish. This is the original constant. It was changed in skein version 1.3    
-    static constexpr uint64_t C240 = 0x5555555555555555;
-    static constexpr int numRounds = 80;  //rounds within threefish
-    static constexpr int numWords = 16;  //number of 64 bit words (1024 bits / 64)
-    static constexpr int subkeyCount = numRounds / 4 + 1;  //21 subkeys
     static constexpr int headerLength = 216;  //bytes (hashing mode)
     static constexpr int headerLengthPrime = 208; 
         
@@ -46,14 +46,6 @@ public:
 
 private:
     using tweakType = std::array<uint64_t, 3>;
-    using subkeyType = std::array<Int_array<uint64_t, numWords>, subkeyCount>;
-    //word permutation constants
-    static constexpr int permuteIndices[numWords] = { 0, 9, 2, 13, 6, 11, 4, 15, 10, 7, 12, 3, 14, 5, 8, 1 };
-    //The original mix function rotation constants.These changed between version 1.1 and 1.2 of Skein
-    static constexpr int R[8][8] = { {55, 43, 37, 40, 16, 22, 38, 12},{25, 25, 46, 13, 14, 13, 52, 57},
-        {33, 8, 18, 57, 21, 12, 32, 54},{34, 43, 25, 60, 44, 9, 59, 34},
-        {28, 7, 47, 48, 51, 9, 35, 41},{17, 6, 18, 25, 43, 42, 40, 15},
-        {58, 7, 32, 45, 19, 18, 2, 56},{47, 49, 27, 58, 37, 48, 53, 56} };
 
     //This is the precomputed config key for the first threefish call.
     const std::string hashInitStr = "56210962be52435aca01f0721a8b6e5f26cea2a19cfecbffca8b036796c3236c6ceb34cefc8b3a583e6aa4d411fbdb3f980930a8fcac0433d20f7fa15f67f6b26babf70e7399259de4a9fe3d0da21409d3db94a4af9c1acc8c38a6a00d032898dce3deaa5d9d330d86a0e2c435de46fcd1a6192ef5e4d653dd1d5d712f956356";
@@ -67,50 +59,21 @@ private:
     static constexpr tweakType t2_prime{ 0x000000000000D0, 0xB000000000000000, 0xB0000000000000D0 };
 
 
-    // Rotate left : 0b1001 -- > 0b0011
-    inline uint64_t rol(uint64_t val, int r_bits)
-    {
-        return (val << r_bits) | (val >> (64 - r_bits));
-    }
-
-    inline uint64_t mix1(uint64_t x0, uint64_t x1)
-    {
-        //first part of the mix function of threefish
-        //x0 and x1 are the two 64 bit inputs
-        //just add them.  overflow is ok here.
-        uint64_t y0 = x0 + x1;
-        return y0;
-    }
-
-    inline uint64_t mix2(uint64_t x1, uint64_t y0, int d, int j)
-    {
-        //second part of the mix function of threefish
-        //x1 is a two 64 bit inputs
-        //y0 is the result of mix 1
-        //d is the threefish round(0 to Nr = 80)
-        //j is the column(0 to 7)
-        //the output is the xor of y0 with a rotated version of x1
-        //the rotation constants repeat every 8 rows hence the d % 8
-        //bitwise rotation by the rotation constant and bitwise xor with y0
-        uint64_t y1 = rol(x1, R[d % 8][j]) ^ y0;
-        return y1;
-    }
-
-    stateType permute(const stateType& s);
-    stateType threefish1024(stateType p, const subkeyType& subkey);
-    void makeSubkeys(const stateType& key, const tweakType& tweak, subkeyType& subkey);
+    stateType threefish1024(const stateType& message, const keyType& key, const tweakType& tweak);
     keyType makeKeyFromState(const stateType& state);
+    const tweakType& tweak2() const { return primeMode ? t2_prime : t2; }
         
     //key2 is a midstate value that is fixed per block (not dependent on the nonce).  
     keyType key2;
+    //threefish2 state after the first subkey and the mixes of the first rounds that do not involve the nonce.
+    //fixed per block.  The nonce is added to word 10 when hashing.
+    stateType midstate2;
     //message2 is the second portion of the block header that includes the nonce. 
     stateType message2;
     //message1 is the first part of the block header.  This is independent of the nonce.
     stateType message1;
     //the state after the first round of threefish.  This is independent of the nonce.
     stateType threefish1Out;
-    //the set of subkeys used as input to round two. This is independent of the nonce.
-    subkeyType subkey2;
     //the fixed initial state for Nexus
     stateType hashInitState;
     //the final output of the skein hash function after three rounds of threefish
@@ -118,12 +81,33 @@ private:
     bool primeMode = false;
 
 public:
-    void setMessage(std::vector<unsigned char>);
+    void setMessage(const std::vector<unsigned char>& m);
+    //the header as a pointer and a length.  Use with Block_data::WriteHeaderBytes to set a block without allocating.
+    void setMessage(const unsigned char* m, size_t length);
     void calculateKey2();
     keyType getKey2();
     stateType getMessage1();
     stateType getMessage2();
     void calculateHash();
+    //Multi lane versions of calculateHash. Each lane hashes a different nonce starting from the midstate.
+    //The nonce set with setNonce is ignored. Only call these if the cpu supports the instruction set (see cpu_features.hpp).
+    //The skein hash of each lane is stored word major in hashes i.e. hashes[word * lanes + lane]
+    void calculateHashSSE2(const uint64_t* nonces, uint64_t* hashes) const;
+    void calculateHashAVX2(const uint64_t* nonces, uint64_t* hashes) const;
+    void calculateHashAVX512(const uint64_t* nonces, uint64_t* hashes) const;
+    //Mining versions.  Skein followed by keccak for each lane with no round trip through memory.
+    //results[lane] is the top 64 bits of the nexus hash (the same as NexusKeccak::calculateResult).
+    void calculateResult(const uint64_t* nonces, uint64_t* results) const;
+    void calculateResultSSE2(const uint64_t* nonces, uint64_t* results) const;
+    void calculateResultAVX2(const uint64_t* nonces, uint64_t* results) const;
+    void calculateResultAVX512(const uint64_t* nonces, uint64_t* results) const;
+    //Batch mining.  Hash count nonces starting at firstNonce and append the ones with result <= threshold to candidates.
+    //The loop runs inside the kernel so nothing is allocated unless a candidate is found.
+    //A leading zero filter of n bits is threshold = ~0ull >> n.
+    void hashRange(uint64_t firstNonce, uint64_t count, uint64_t threshold, std::vector<Candidate>& candidates) const;
+    void hashRangeSSE2(uint64_t firstNonce, uint64_t count, uint64_t threshold, std::vector<Candidate>& candidates) const;
+    void hashRangeAVX2(uint64_t firstNonce, uint64_t count, uint64_t threshold, std::vector<Candidate>& candidates) const;
+    void hashRangeAVX512(uint64_t firstNonce, uint64_t count, uint64_t threshold, std::vector<Candidate>& candidates) const;
     stateType getHash();
     void setNonce(uint64_t nonce);
     uint64_t getNonce();
@@ -0,0 +1,82 @@
+#include "hash/cpu_features.hpp"
+#include <cstdint>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
+namespace
+{
+#if defined(HASH_SIMD_ENABLED)
+uint64_t xgetbv()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+CpuFeatures detectCpuFeatures()
+{
+    CpuFeatures features;
+#if defined(HASH_SIMD_ENABLED)
+    uint32_t regs[4];
+    if (!cpuid(1, 0, regs))
+        return features;
+
+    features.sse2 = (regs[3] >> 26) & 1;
+
+    bool const osxsave = (regs[2] >> 27) & 1;
+    bool const avx = (regs[2] >> 28) & 1;
+    if (!osxsave || !avx)
+        return features;
+
+    //the os must save the ymm (and zmm) registers on a context switch
+    uint64_t const xcr0 = xgetbv();
+    bool const ymmEnabled = (xcr0 & 0x06) == 0x06;
+    bool const zmmEnabled = (xcr0 & 0xE6) == 0xE6;
+
+    if (!cpuid(7, 0, regs))
+        return features;
+    features.avx2 = ymmEnabled && ((regs[1] >> 5) & 1);
+    features.avx512 = zmmEnabled && ((regs[1] >> 16) & 1);
+#endif
+    return features;
+}
+}
+
+bool cpuid(uint32_t leaf, uint32_t subleaf, uint32_t (&regs)[4])
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    //the highest leaf of the basic (0) or extended (0x80000000) range
+    int info[4];
+    __cpuid(info, static_cast<int>(leaf & 0x80000000U));
+    if (static_cast<uint32_t>(info[0]) < leaf)
+        return false;
+    __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; i++)
+        regs[i] = static_cast<uint32_t>(info[i]);
+    return true;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    if (__get_cpuid_max(leaf & 0x80000000U, nullptr) < leaf)
+        return false;
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+    return true;
+#else
+    (void)leaf;
+    (void)subleaf;
+    (void)regs;
+    return false;
+#endif
+}
+
+const CpuFeatures& getCpuFeatures()
+{
+    static const CpuFeatures features = detectCpuFeatures();
+    return features;
+}
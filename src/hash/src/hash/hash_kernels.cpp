@@ -0,0 +1,28 @@
+#include "hash/hash_kernels.hpp"
+#include "hash/cpu_features.hpp"
+
+const std::vector<HashKernel>& getHashKernels()
+{
+    static const std::vector<HashKernel> kernels = []()
+    {
+        const CpuFeatures& features = getCpuFeatures();
+        return std::vector<HashKernel>{
+            { "scalar", 1, true, &NexusSkein::calculateResult, &NexusSkein::hashRange },
+            { "sse2", NexusSkein::lanesSSE2, features.sse2, &NexusSkein::calculateResultSSE2, &NexusSkein::hashRangeSSE2 },
+            { "avx2", NexusSkein::lanesAVX2, features.avx2, &NexusSkein::calculateResultAVX2, &NexusSkein::hashRangeAVX2 },
+            { "avx512", NexusSkein::lanesAVX512, features.avx512, &NexusSkein::calculateResultAVX512, &NexusSkein::hashRangeAVX512 } };
+    }();
+    return kernels;
+}
+
+const HashKernel* findHashKernel(const std::string& name)
+{
+    for (const auto& kernel : getHashKernels())
+    {
+        if (kernel.name == name)
+        {
+            return &kernel;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,55 @@
+#ifndef NEXUS_HASH_RANGE_HPP
+#define NEXUS_HASH_RANGE_HPP
+//Mining loop over a range of nonces.  Shared by the scalar and the multi lane kernels.
+//The candidates go to a fixed size buffer so the loop does not allocate.  The caller copies them out.
+
+#include "hash/hash_constants.hpp"
+#include "threefish.hpp"
+#include "keccak.hpp"
+#include <cstdint>
+
+namespace skein_lanes
+{
+namespace
+{
+
+//Hash up to count nonces starting at firstNonce.  Nonces with result <= threshold are written to candidates.
+//Stops early when the candidate buffer might overflow on the next call of the kernel.
+//Returns the number of nonces hashed.  candidateCount is the number of candidates written.
+template <typename Lanes>
+inline uint64_t hashRange(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+    const uint64_t* tweak2, const uint64_t* tweak3, uint64_t firstNonce, uint64_t count, uint64_t threshold,
+    SkeinConstants::Candidate* candidates, int maxCandidates, int& candidateCount)
+{
+    constexpr int lanes = Lanes::lanes;
+    uint64_t nonces[lanes];
+    uint64_t results[lanes];
+    typename Lanes::vec hash[SkeinConstants::numWords];
+    candidateCount = 0;
+    uint64_t done = 0;
+    while (done < count && candidateCount + lanes <= maxCandidates)
+    {
+        for (int lane = 0; lane < lanes; lane++)
+        {
+            nonces[lane] = firstNonce + done + lane;
+        }
+        Threefish<Lanes>::skein(midstate2, key2, message2, tweak2, tweak3, nonces, hash);
+        Lanes::store(results, Keccak<Lanes>::calculateResult(hash));
+        //the last call may hash a few nonces past the end of the range.  They are ignored.
+        int const valid = count - done < lanes ? static_cast<int>(count - done) : lanes;
+        for (int lane = 0; lane < valid; lane++)
+        {
+            if (results[lane] <= threshold)
+            {
+                candidates[candidateCount++] = { nonces[lane], results[lane] };
+            }
+        }
+        done += valid;
+    }
+    return done;
+}
+
+}
+}
+
+#endif
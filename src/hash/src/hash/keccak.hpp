@@ -0,0 +1,146 @@
+#ifndef NEXUS_KECCAK_LANES_HPP
+#define NEXUS_KECCAK_LANES_HPP
+//Keccak for mining.  Computes only the top 64 bits of the nexus hash (NexusKeccak::getResult).
+//Lanes is the same register wrapper used by threefish.hpp plus andnot(a, b) = ~a & b.
+//The state is a flat array of 25 words, word 5y + x is lane (x, y).
+//The round loop is kept but each round is unrolled so the rotation constants become immediates.
+//Only 3 of the 25 lanes of the last round feed the result so the rest of the last round is skipped.
+
+#include "hash/hash_constants.hpp"
+#include "lanes_scalar.hpp"
+#include <cstdint>
+#include <utility>
+
+namespace skein_lanes
+{
+namespace
+{
+
+template <typename Lanes>
+struct Keccak
+{
+    using vec = typename Lanes::vec;
+    static constexpr int stateWords = KeccakConstants::numPlane * KeccakConstants::numSheet;
+    static constexpr int hashWords = 16;
+    //hash2[1][1], the top 64 bits of the hash
+    static constexpr int resultLane = 6;
+
+    template <int bits>
+    static inline vec rol(vec x)
+    {
+        if constexpr (bits == 0)
+            return x;
+        else
+            return Lanes::template rol<bits>(x);
+    }
+
+    //rho and pi move lane (x, y) to b[5y + (2x + 3y) % 5].  This is the inverse.
+    static constexpr int rhoPiSource(int dest)
+    {
+        int y = dest / 5;
+        int x = (3 * (dest % 5 + 5 * 5 - 3 * y)) % 5;
+        return 5 * y + x;
+    }
+
+    static inline void theta(const vec (&a)[stateWords], vec (&d)[5])
+    {
+        vec c[5];
+        for (int x = 0; x < 5; x++)
+        {
+            c[x] = Lanes::xor_(Lanes::xor_(Lanes::xor_(a[x], a[x + 5]), Lanes::xor_(a[x + 10], a[x + 15])), a[x + 20]);
+        }
+        for (int x = 0; x < 5; x++)
+        {
+            d[x] = Lanes::xor_(c[(x + 4) % 5], rol<1>(c[(x + 1) % 5]));
+        }
+    }
+
+    template <int I>
+    static inline void rhoPi(const vec (&a)[stateWords], const vec (&d)[5], vec (&b)[stateWords])
+    {
+        constexpr int x = I % 5;
+        constexpr int y = I / 5;
+        b[5 * y + (2 * x + 3 * y) % 5] = rol<KeccakConstants::r[x][y]>(Lanes::xor_(a[I], d[x]));
+    }
+
+    template <int I>
+    static inline vec chi(const vec (&b)[stateWords])
+    {
+        constexpr int x = I % 5;
+        constexpr int y = I / 5;
+        return Lanes::xor_(b[5 * x + y], Lanes::andnot(b[5 * ((x + 1) % 5) + y], b[5 * ((x + 2) % 5) + y]));
+    }
+
+    template <int... I>
+    static inline void round(vec (&a)[stateWords], int round, std::integer_sequence<int, I...>)
+    {
+        vec d[5];
+        vec b[stateWords];
+        theta(a, d);
+        (rhoPi<I>(a, d, b), ...);
+        ((a[I] = chi<I>(b)), ...);
+        a[0] = Lanes::xor_(a[0], Lanes::set1(KeccakConstants::round_const[round]));
+    }
+
+    static inline void permute(vec (&a)[stateWords], int rounds = KeccakConstants::numRounds)
+    {
+        for (int i = 0; i < rounds; i++)
+        {
+            round(a, i, std::make_integer_sequence<int, stateWords>{});
+        }
+    }
+
+    //last round of the last permutation for output lane I only
+    template <int I>
+    static inline vec lastRound(const vec (&a)[stateWords])
+    {
+        constexpr int x = I % 5;
+        constexpr int y = I / 5;
+        vec d[5];
+        vec b[stateWords];
+        theta(a, d);
+        rhoPi<rhoPiSource(5 * x + y)>(a, d, b);
+        rhoPi<rhoPiSource(5 * ((x + 1) % 5) + y)>(a, d, b);
+        rhoPi<rhoPiSource(5 * ((x + 2) % 5) + y)>(a, d, b);
+        vec result = chi<I>(b);
+        if constexpr (I == 0)
+        {
+            result = Lanes::xor_(result, Lanes::set1(KeccakConstants::round_const[KeccakConstants::numRounds - 1]));
+        }
+        return result;
+    }
+
+    //m is the 16 word skein hash
+    static inline vec calculateResult(const vec (&m)[hashWords])
+    {
+        constexpr int messageLength = KeccakConstants::messageLength;
+        vec a[stateWords];
+        for (int i = 0; i < messageLength; i++)
+        {
+            a[i] = m[i];
+        }
+        for (int i = messageLength; i < stateWords; i++)
+        {
+            a[i] = Lanes::set1(0);
+        }
+        permute(a);
+
+        //absorb the rest of the skein hash and the nxs suffix
+        for (int i = 0; i < hashWords - messageLength; i++)
+        {
+            a[i] = Lanes::xor_(a[i], m[messageLength + i]);
+        }
+        a[hashWords - messageLength] = Lanes::xor_(a[hashWords - messageLength], Lanes::set1(KeccakConstants::NXS_SUFFIX_1));
+        a[messageLength - 1] = Lanes::xor_(a[messageLength - 1], Lanes::set1(KeccakConstants::NXS_SUFFIX_2));
+        permute(a);
+
+        //the third permutation is only needed for the upper bits of the hash
+        permute(a, KeccakConstants::numRounds - 1);
+        return lastRound<resultLane>(a);
+    }
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef NEXUS_LANES_SCALAR_HPP
+#define NEXUS_LANES_SCALAR_HPP
+//Single lane version of the lanes wrapper used by the threefish and keccak templates.
+
+#include <cstdint>
+
+namespace skein_lanes
+{
+namespace
+{
+
+//plain 64 bit integer.  Safe to use from any translation unit.
+struct LanesScalar
+{
+    using vec = uint64_t;
+    static constexpr int lanes = 1;
+
+    static inline vec set1(uint64_t x) { return x; }
+    static inline vec load(const uint64_t* p) { return *p; }
+    static inline void store(uint64_t* p, vec x) { *p = x; }
+    static inline vec add(vec a, vec b) { return a + b; }
+    static inline vec xor_(vec a, vec b) { return a ^ b; }
+    //~a & b
+    static inline vec andnot(vec a, vec b) { return ~a & b; }
+    template <int bits> static inline vec rol(vec x) { return (x << bits) | (x >> (64 - bits)); }
+};
+
+}
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "hash/nexus_keccak.hpp"
+#include "keccak.hpp"
 
 NexusKeccak::NexusKeccak()
 {
@@ -121,6 +122,22 @@ uint64_t NexusKeccak::getResult()
 	return hash2[1][1];
 }
 
+uint64_t NexusKeccak::calculateResult() const
+{
+	using Keccak = skein_lanes::Keccak<skein_lanes::LanesScalar>;
+	//reassemble the skein hash from the two message parts.  The suffix is added by the kernel.
+	uint64_t m[Keccak::hashWords];
+	for (int i = 0; i < messageLength; i++)
+	{
+		m[i] = message1[i];
+	}
+	for (int i = messageLength; i < Keccak::hashWords; i++)
+	{
+		m[i] = message2[i - messageLength];
+	}
+	return Keccak::calculateResult(m);
+}
+
 NexusKeccak::k_1024 NexusKeccak::getHashResult()
 {
 	k_1024 hash_result;
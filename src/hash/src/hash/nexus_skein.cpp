@@ -1,5 +1,29 @@
 #include "hash/nexus_skein.hpp"
+#include "skein_lanes.hpp"
+#include "threefish.hpp"
+#include "keccak.hpp"
+#include "hash_range.hpp"
 
+namespace
+{
+//candidates of one call to a hash range kernel.  With a useful threshold there are hardly ever more than one or two.
+constexpr int candidateBufferSize = 64;
+
+//run the kernel over the whole range and move the candidates from its fixed buffer to the vector
+template <typename Kernel>
+void collectCandidates(Kernel&& kernel, uint64_t firstNonce, uint64_t count, std::vector<NexusSkein::Candidate>& candidates)
+{
+    NexusSkein::Candidate buffer[candidateBufferSize];
+    while (count > 0)
+    {
+        int found = 0;
+        uint64_t done = kernel(firstNonce, count, buffer, found);
+        candidates.insert(candidates.end(), buffer, buffer + found);
+        firstNonce += done;
+        count -= done;
+    }
+}
+}
 
 NexusSkein::NexusSkein() 
 {
@@ -13,76 +37,27 @@ NexusSkein::NexusSkein(const std::vector<unsigned char>& m)
     setMessage(m);
 }
 
-NexusSkein::stateType NexusSkein::permute(const stateType& s)
-//rearrange the words
+NexusSkein::stateType NexusSkein::threefish1024(const stateType& message, const keyType& key, const tweakType& tweak)
 {
-    stateType p;
-    int j = 0;
-    for (const auto& i : permuteIndices)
+    //threefish is a core part of the Skein hash algorithm.  The nexus hash calls this three times.
+    using Threefish = skein_lanes::Threefish<skein_lanes::LanesScalar>;
+    uint64_t v[numWords];
+    uint64_t k[numWords + 1];
+    for (int i = 0; i < numWords; i++)
     {
-        p[j] = s[i];
-        j++;
+        v[i] = message[i];
     }
-    return p;
-}
-
-NexusSkein::stateType NexusSkein::threefish1024(stateType v, const subkeyType& subkey)
-{
-    //threefish is a core part of the Skein hash algorithm.  The nexus hash calls this three times.
-    stateType f;  //holds the result of the mix
-    for (auto d = 0; d < numRounds; d++)
+    for (int i = 0; i < numWords + 1; i++)
     {
-        if ((d % 4) == 0)
-        {
-            // add a subkey every fourth round
-            v = v + subkey[d / 4];
-        }
-        // 8 mixes per round
-        for (auto j = 0; j < numWords / 2; j++)
-        {
-            f[2 * j] = mix1(v[2 * j], v[2 * j + 1]);
-            f[2 * j + 1] = mix2(v[2 * j + 1], f[2 * j], d, j);
-        }
-        // 1 permute per round
-        v = permute(f);
-        /*if ((d % 4) == 3)
-        {
-            std::cout << "Threefish round " << d / 4 << " output: " << std::endl;
-            v.print();
-        }*/
-
+        k[i] = key[i];
     }
-    // add the final subkey
-    v = v + subkey[subkeyCount - 1];
-    //std::cout << "Threefish output: " << std::endl;
-    //v.print();
-    return v;
-}
-
-void NexusSkein::makeSubkeys(const stateType& keyIn, const tweakType& tweak, subkeyType& subkey)
-//generate subkeys for threefish
-{
-    keyType key = makeKeyFromState(keyIn);
-    for (int s = 0; s < subkeyCount; s++)
+    Threefish::threefish1024(v, k, tweak.data());
+    stateType result;
+    for (int i = 0; i < numWords; i++)
     {
-        for (int i = 0; i < numWords; i++)
-        {
-            subkey[s][i] = key[(s + i) % (numWords + 1)];
-            if (i == numWords - 3)
-            {
-                subkey[s][i] += tweak[s % 3];  //overflow is ok here
-            }
-            if (i == numWords - 2)
-            {
-                subkey[s][i] += tweak[(s + 1) % 3];  //overflow is ok here
-            }
-            if (i == numWords - 1)
-            {
-                subkey[s][i] += s;
-            }
-            //std::cout << "subkey " << std::dec << s << ", " << i << " " << std::hex << std::uppercase << std::setfill('0') << std::setw(16) << subkey[s][i] << std::endl;
-        }
+        result[i] = v[i];
     }
+    return result;
 }
 
 NexusSkein::keyType NexusSkein::makeKeyFromState(const stateType& state)
@@ -99,22 +74,22 @@ NexusSkein::keyType NexusSkein::makeKeyFromState(const stateType& state)
     return key;
 }
 
-void NexusSkein::setMessage(std::vector<unsigned char> m)
+void NexusSkein::setMessage(const std::vector<unsigned char>& m)
+{
+    setMessage(m.data(), m.size());
+}
+
+void NexusSkein::setMessage(const unsigned char* m, size_t length)
 {
     //Take a header input as a byte array and process as much of thge hash as possible prior to involving the nonce.
     //This generates the midstate value used in mining.
     //The input message must match the nexus header length (216 bytes)
-    if (m.size() == headerLength || m.size() == headerLengthPrime)
+    if (length == headerLength || length == headerLengthPrime)
     {
-        primeMode = m.size() == headerLengthPrime;
-        //break the message into 2 128 byte chunks
-        std::vector<unsigned char> m1(m.begin(), m.begin() + 128);
-        std::vector<unsigned char> m2(m.begin() + 128, m.end());
-        //pad the end of the header with zeros to make 128 bytes total
-        for (auto i = m2.size(); i < 128; i++)
-            m2.push_back(0);
-        message1.fromBytes(m1);
-        message2.fromBytes(m2);
+        primeMode = length == headerLengthPrime;
+        //break the message into 2 128 byte chunks.  fromBytes pads the end of the header with zeros to make 128 bytes total
+        message1.fromBytes(m, 128);
+        message2.fromBytes(m + 128, length - 128);
         //calculate the midstate
         calculateKey2();
     }
@@ -127,37 +102,167 @@ void NexusSkein::setMessage(std::vector<unsigned char> m)
 void NexusSkein::calculateKey2()
 {
     //first of three threefish calls.  This one is fixed for the block (not dependent on the nonce).
-    subkeyType subkey;
-    makeSubkeys(hashInitState, t1, subkey);
-    stateType tf1 = threefish1024(message1, subkey);
+    stateType tf1 = threefish1024(message1, makeKeyFromState(hashInitState), t1);
     //after threefish we xor the result with the message
     threefish1Out = tf1 ^ message1;
     //generate the key for the next round.  this is used as input to the mining stage
     key2 = makeKeyFromState(threefish1Out);
-    if (primeMode)
-        makeSubkeys(threefish1Out, t2_prime, subkey2);
-    else
-        makeSubkeys(threefish1Out, t2, subkey2);
-
+    //precompute the part of threefish2 that is the same for every nonce (nonce-delta midstate)
+    skein_lanes::Threefish<skein_lanes::LanesScalar>::precomputeThreefish2(&key2[0], &message2[0], tweak2().data(), &midstate2[0]);
 }
 
 void NexusSkein::calculateHash()
 {
     //Completes the hash.  You must call setMessage once for the block before calling this 
+    //second and third threefish calls.  The subkeys are generated on the fly from key2 and the threefish2 output.
+    skein_lanes::Threefish<skein_lanes::LanesScalar>::calculateHash(&midstate2[0], &key2[0], &message2[0], tweak2().data(), t3.data(),
+        &message2[10], &hash[0]);
+}
+
+void NexusSkein::calculateResult(const uint64_t* nonces, uint64_t* results) const
+{
+    using Lanes = skein_lanes::LanesScalar;
+    Lanes::vec skeinHash[numWords];
+    skein_lanes::Threefish<Lanes>::skein(&midstate2[0], &key2[0], &message2[0], tweak2().data(), t3.data(), nonces, skeinHash);
+    results[0] = skein_lanes::Keccak<Lanes>::calculateResult(skeinHash);
+}
+
+void NexusSkein::hashRange(uint64_t firstNonce, uint64_t count, uint64_t threshold, std::vector<Candidate>& candidates) const
+{
+    collectCandidates([&](uint64_t first, uint64_t n, Candidate* buffer, int& found)
+    {
+        return skein_lanes::hashRange<skein_lanes::LanesScalar>(&midstate2[0], &key2[0], &message2[0], tweak2().data(), t3.data(),
+            first, n, threshold, buffer, candidateBufferSize, found);
+    }, firstNonce, count, candidates);
+}
 
-    //second threefish call
-    stateType tf2 = threefish1024(message2, subkey2);
-    //xor the result with the message
-    stateType threefish2Out = tf2 ^ message2;
+#if defined(HASH_SIMD_ENABLED)
+void NexusSkein::calculateHashSSE2(const uint64_t* nonces, uint64_t* hashes) const
+{
+    skein_lanes::calculateHashSSE2(&midstate2[0], &key2[0], &message2[0], tweak2().data(), t3.data(), nonces, hashes);
+}
 
-    //third threefish call.  
-    //the final threefish input is all zeros.
-    stateType message3;  
-    subkeyType subkey;
-    makeSubkeys(threefish2Out, t3, subkey);
-    hash = threefish1024(message3, subkey);
-    //no need for a final xor because the message for round 3 is all zeros.
+void NexusSkein::calculateHashAVX2(const uint64_t* nonces, uint64_t* hashes) const
+{
+    skein_lanes::calculateHashAVX2(&midstate2[0], &key2[0], &message2[0], tweak2().data(), t3.data(), nonces, hashes);
+}
+
+void NexusSkein::calculateHashAVX512(const uint64_t* nonces, uint64_t* hashes) const
+{
+    skein_lanes::calculateHashAVX512(&midstate2[0], &key2[0], &message2[0], tweak2().data(), t3.data(), nonces, hashes);
+}
+
+void NexusSkein::calculateResultSSE2(const uint64_t* nonces, uint64_t* results) const
+{
+    skein_lanes::calculateResultSSE2(&midstate2[0], &key2[0], &message2[0], tweak2().data(), t3.data(), nonces, results);
+}
+
+void NexusSkein::calculateResultAVX2(const uint64_t* nonces, uint64_t* results) const
+{
+    skein_lanes::calculateResultAVX2(&midstate2[0], &key2[0], &message2[0], tweak2().data(), t3.data(), nonces, results);
+}
+
+void NexusSkein::calculateResultAVX512(const uint64_t* nonces, uint64_t* results) const
+{
+    skein_lanes::calculateResultAVX512(&midstate2[0], &key2[0], &message2[0], tweak2().data(), t3.data(), nonces, results);
+}
+void NexusSkein::hashRangeSSE2(uint64_t firstNonce, uint64_t count, uint64_t threshold, std::vector<Candidate>& candidates) const
+{
+    collectCandidates([&](uint64_t first, uint64_t n, Candidate* buffer, int& found)
+    {
+        return skein_lanes::hashRangeSSE2(&midstate2[0], &key2[0], &message2[0], tweak2().data(), t3.data(),
+            first, n, threshold, buffer, candidateBufferSize, found);
+    }, firstNonce, count, candidates);
+}
+
+void NexusSkein::hashRangeAVX2(uint64_t firstNonce, uint64_t count, uint64_t threshold, std::vector<Candidate>& candidates) const
+{
+    collectCandidates([&](uint64_t first, uint64_t n, Candidate* buffer, int& found)
+    {
+        return skein_lanes::hashRangeAVX2(&midstate2[0], &key2[0], &message2[0], tweak2().data(), t3.data(),
+            first, n, threshold, buffer, candidateBufferSize, found);
+    }, firstNonce, count, candidates);
+}
+
+void NexusSkein::hashRangeAVX512(uint64_t firstNonce, uint64_t count, uint64_t threshold, std::vector<Candidate>& candidates) const
+{
+    collectCandidates([&](uint64_t first, uint64_t n, Candidate* buffer, int& found)
+    {
+        return skein_lanes::hashRangeAVX512(&midstate2[0], &key2[0], &message2[0], tweak2().data(), t3.data(),
+            first, n, threshold, buffer, candidateBufferSize, found);
+    }, firstNonce, count, candidates);
+}
+#else
+//no simd kernels for this architecture.  Fall back to the scalar hash one lane at a time.
+void NexusSkein::calculateHashSSE2(const uint64_t* nonces, uint64_t* hashes) const
+{
+    NexusSkein skein = *this;
+    for (int lane = 0; lane < lanesSSE2; lane++)
+    {
+        skein.setNonce(nonces[lane]);
+        skein.calculateHash();
+        for (int i = 0; i < numWords; i++)
+            hashes[i * lanesSSE2 + lane] = skein.hash[i];
+    }
+}
+
+void NexusSkein::calculateHashAVX2(const uint64_t* nonces, uint64_t* hashes) const
+{
+    NexusSkein skein = *this;
+    for (int lane = 0; lane < lanesAVX2; lane++)
+    {
+        skein.setNonce(nonces[lane]);
+        skein.calculateHash();
+        for (int i = 0; i < numWords; i++)
+            hashes[i * lanesAVX2 + lane] = skein.hash[i];
+    }
+}
+
+void NexusSkein::calculateHashAVX512(const uint64_t* nonces, uint64_t* hashes) const
+{
+    NexusSkein skein = *this;
+    for (int lane = 0; lane < lanesAVX512; lane++)
+    {
+        skein.setNonce(nonces[lane]);
+        skein.calculateHash();
+        for (int i = 0; i < numWords; i++)
+            hashes[i * lanesAVX512 + lane] = skein.hash[i];
+    }
+}
+
+void NexusSkein::calculateResultSSE2(const uint64_t* nonces, uint64_t* results) const
+{
+    for (int lane = 0; lane < lanesSSE2; lane++)
+        calculateResult(nonces + lane, results + lane);
+}
+
+void NexusSkein::calculateResultAVX2(const uint64_t* nonces, uint64_t* results) const
+{
+    for (int lane = 0; lane < lanesAVX2; lane++)
+        calculateResult(nonces + lane, results + lane);
+}
+
+void NexusSkein::calculateResultAVX512(const uint64_t* nonces, uint64_t* results) const
+{
+    for (int lane = 0; lane < lanesAVX512; lane++)
+        calculateResult(nonces + lane, results + lane);
+}
+
+void NexusSkein::hashRangeSSE2(uint64_t firstNonce, uint64_t count, uint64_t threshold, std::vector<Candidate>& candidates) const
+{
+    hashRange(firstNonce, count, threshold, candidates);
+}
+
+void NexusSkein::hashRangeAVX2(uint64_t firstNonce, uint64_t count, uint64_t threshold, std::vector<Candidate>& candidates) const
+{
+    hashRange(firstNonce, count, threshold, candidates);
+}
+
+void NexusSkein::hashRangeAVX512(uint64_t firstNonce, uint64_t count, uint64_t threshold, std::vector<Candidate>& candidates) const
+{
+    hashRange(firstNonce, count, threshold, candidates);
 }
+#endif
 
 NexusSkein::keyType NexusSkein::getKey2()
 {
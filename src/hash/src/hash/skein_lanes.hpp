@@ -0,0 +1,42 @@
+#ifndef NEXUS_SKEIN_LANES_HPP
+#define NEXUS_SKEIN_LANES_HPP
+//Multi lane threefish2 + threefish3 (+ keccak) kernels.  Each lane hashes a different nonce starting from the same per block midstate.
+//Every instruction set lives in its own translation unit compiled with the matching compiler flags. 
+//Only call a kernel after checking the cpu supports it.
+
+#include "hash/hash_constants.hpp"
+#include <cstdint>
+
+namespace skein_lanes
+{
+    //midstate2 is the per block threefish2 precompute (16 words), key2 is 17 words, message2 16 words, tweaks 3 words.
+    //The nonces replace word 10 of message2.
+    //the skein hash of each lane is stored word major i.e. hashes[word * lanes + lane]
+    void calculateHashSSE2(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+        const uint64_t* tweak2, const uint64_t* tweak3, const uint64_t* nonces, uint64_t* hashes);
+    void calculateHashAVX2(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+        const uint64_t* tweak2, const uint64_t* tweak3, const uint64_t* nonces, uint64_t* hashes);
+    void calculateHashAVX512(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+        const uint64_t* tweak2, const uint64_t* tweak3, const uint64_t* nonces, uint64_t* hashes);
+
+    //skein followed by the mining keccak.  results[lane] is the top 64 bits of the nexus hash of each lane.
+    void calculateResultSSE2(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+        const uint64_t* tweak2, const uint64_t* tweak3, const uint64_t* nonces, uint64_t* results);
+    void calculateResultAVX2(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+        const uint64_t* tweak2, const uint64_t* tweak3, const uint64_t* nonces, uint64_t* results);
+    void calculateResultAVX512(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+        const uint64_t* tweak2, const uint64_t* tweak3, const uint64_t* nonces, uint64_t* results);
+
+    //mining loop over a range of nonces (see hash_range.hpp).  Returns the number of nonces hashed.
+    uint64_t hashRangeSSE2(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+        const uint64_t* tweak2, const uint64_t* tweak3, uint64_t firstNonce, uint64_t count, uint64_t threshold,
+        SkeinConstants::Candidate* candidates, int maxCandidates, int& candidateCount);
+    uint64_t hashRangeAVX2(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+        const uint64_t* tweak2, const uint64_t* tweak3, uint64_t firstNonce, uint64_t count, uint64_t threshold,
+        SkeinConstants::Candidate* candidates, int maxCandidates, int& candidateCount);
+    uint64_t hashRangeAVX512(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+        const uint64_t* tweak2, const uint64_t* tweak3, uint64_t firstNonce, uint64_t count, uint64_t threshold,
+        SkeinConstants::Candidate* candidates, int maxCandidates, int& candidateCount);
+}
+
+#endif
@@ -0,0 +1,51 @@
+//compiled with AVX2 enabled.  Keep includes to a minimum so no shared inline code is generated with AVX2 instructions.
+#include "skein_lanes.hpp"
+#include "threefish.hpp"
+#include "keccak.hpp"
+#include "hash_range.hpp"
+#include <immintrin.h>
+
+namespace skein_lanes
+{
+namespace
+{
+struct LanesAVX2
+{
+    using vec = __m256i;
+    static constexpr int lanes = SkeinConstants::lanesAVX2;
+
+    static inline vec set1(uint64_t x) { return _mm256_set1_epi64x(static_cast<long long>(x)); }
+    static inline vec load(const uint64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static inline void store(uint64_t* p, vec x) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), x); }
+    static inline vec add(vec a, vec b) { return _mm256_add_epi64(a, b); }
+    static inline vec xor_(vec a, vec b) { return _mm256_xor_si256(a, b); }
+    //~a & b
+    static inline vec andnot(vec a, vec b) { return _mm256_andnot_si256(a, b); }
+    //AVX2 has no 64 bit rotate
+    template <int bits> static inline vec rol(vec x) { return _mm256_or_si256(_mm256_slli_epi64(x, bits), _mm256_srli_epi64(x, 64 - bits)); }
+};
+}
+
+void calculateHashAVX2(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+    const uint64_t* tweak2, const uint64_t* tweak3, const uint64_t* nonces, uint64_t* hashes)
+{
+    Threefish<LanesAVX2>::calculateHash(midstate2, key2, message2, tweak2, tweak3, nonces, hashes);
+}
+
+void calculateResultAVX2(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+    const uint64_t* tweak2, const uint64_t* tweak3, const uint64_t* nonces, uint64_t* results)
+{
+    LanesAVX2::vec hash[SkeinConstants::numWords];
+    Threefish<LanesAVX2>::skein(midstate2, key2, message2, tweak2, tweak3, nonces, hash);
+    LanesAVX2::store(results, Keccak<LanesAVX2>::calculateResult(hash));
+}
+
+uint64_t hashRangeAVX2(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+    const uint64_t* tweak2, const uint64_t* tweak3, uint64_t firstNonce, uint64_t count, uint64_t threshold,
+    SkeinConstants::Candidate* candidates, int maxCandidates, int& candidateCount)
+{
+    return hashRange<LanesAVX2>(midstate2, key2, message2, tweak2, tweak3, firstNonce, count, threshold,
+        candidates, maxCandidates, candidateCount);
+}
+
+}
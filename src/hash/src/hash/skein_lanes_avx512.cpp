@@ -0,0 +1,52 @@
+//compiled with AVX-512F enabled.  Keep includes to a minimum so no shared inline code is generated with AVX-512 instructions.
+#include "skein_lanes.hpp"
+#include "threefish.hpp"
+#include "keccak.hpp"
+#include "hash_range.hpp"
+#include <immintrin.h>
+
+namespace skein_lanes
+{
+namespace
+{
+//andnot and rol use the masked intrinsics with all lanes selected.
+//The unmasked versions trip a false uninitialized warning in gcc 12.
+struct LanesAVX512
+{
+    using vec = __m512i;
+    static constexpr int lanes = SkeinConstants::lanesAVX512;
+
+    static inline vec set1(uint64_t x) { return _mm512_set1_epi64(static_cast<long long>(x)); }
+    static inline vec load(const uint64_t* p) { return _mm512_loadu_si512(p); }
+    static inline void store(uint64_t* p, vec x) { _mm512_storeu_si512(p, x); }
+    static inline vec add(vec a, vec b) { return _mm512_add_epi64(a, b); }
+    static inline vec xor_(vec a, vec b) { return _mm512_xor_si512(a, b); }
+    //~a & b
+    static inline vec andnot(vec a, vec b) { return _mm512_mask_andnot_epi64(a, 0xFF, a, b); }
+    template <int bits> static inline vec rol(vec x) { return _mm512_mask_rol_epi64(x, 0xFF, x, bits); }
+};
+}
+
+void calculateHashAVX512(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+    const uint64_t* tweak2, const uint64_t* tweak3, const uint64_t* nonces, uint64_t* hashes)
+{
+    Threefish<LanesAVX512>::calculateHash(midstate2, key2, message2, tweak2, tweak3, nonces, hashes);
+}
+
+void calculateResultAVX512(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+    const uint64_t* tweak2, const uint64_t* tweak3, const uint64_t* nonces, uint64_t* results)
+{
+    LanesAVX512::vec hash[SkeinConstants::numWords];
+    Threefish<LanesAVX512>::skein(midstate2, key2, message2, tweak2, tweak3, nonces, hash);
+    LanesAVX512::store(results, Keccak<LanesAVX512>::calculateResult(hash));
+}
+
+uint64_t hashRangeAVX512(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+    const uint64_t* tweak2, const uint64_t* tweak3, uint64_t firstNonce, uint64_t count, uint64_t threshold,
+    SkeinConstants::Candidate* candidates, int maxCandidates, int& candidateCount)
+{
+    return hashRange<LanesAVX512>(midstate2, key2, message2, tweak2, tweak3, firstNonce, count, threshold,
+        candidates, maxCandidates, candidateCount);
+}
+
+}
@@ -0,0 +1,51 @@
+//compiled with SSE2 enabled.  Keep includes to a minimum so no shared inline code is generated with SSE2 instructions.
+#include "skein_lanes.hpp"
+#include "threefish.hpp"
+#include "keccak.hpp"
+#include "hash_range.hpp"
+#include <emmintrin.h>
+
+namespace skein_lanes
+{
+namespace
+{
+struct LanesSSE2
+{
+    using vec = __m128i;
+    static constexpr int lanes = SkeinConstants::lanesSSE2;
+
+    static inline vec set1(uint64_t x) { return _mm_set1_epi64x(static_cast<long long>(x)); }
+    static inline vec load(const uint64_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static inline void store(uint64_t* p, vec x) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), x); }
+    static inline vec add(vec a, vec b) { return _mm_add_epi64(a, b); }
+    static inline vec xor_(vec a, vec b) { return _mm_xor_si128(a, b); }
+    //~a & b
+    static inline vec andnot(vec a, vec b) { return _mm_andnot_si128(a, b); }
+    //SSE2 has no 64 bit rotate
+    template <int bits> static inline vec rol(vec x) { return _mm_or_si128(_mm_slli_epi64(x, bits), _mm_srli_epi64(x, 64 - bits)); }
+};
+}
+
+void calculateHashSSE2(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+    const uint64_t* tweak2, const uint64_t* tweak3, const uint64_t* nonces, uint64_t* hashes)
+{
+    Threefish<LanesSSE2>::calculateHash(midstate2, key2, message2, tweak2, tweak3, nonces, hashes);
+}
+
+void calculateResultSSE2(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+    const uint64_t* tweak2, const uint64_t* tweak3, const uint64_t* nonces, uint64_t* results)
+{
+    LanesSSE2::vec hash[SkeinConstants::numWords];
+    Threefish<LanesSSE2>::skein(midstate2, key2, message2, tweak2, tweak3, nonces, hash);
+    LanesSSE2::store(results, Keccak<LanesSSE2>::calculateResult(hash));
+}
+
+uint64_t hashRangeSSE2(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+    const uint64_t* tweak2, const uint64_t* tweak3, uint64_t firstNonce, uint64_t count, uint64_t threshold,
+    SkeinConstants::Candidate* candidates, int maxCandidates, int& candidateCount)
+{
+    return hashRange<LanesSSE2>(midstate2, key2, message2, tweak2, tweak3, firstNonce, count, threshold,
+        candidates, maxCandidates, candidateCount);
+}
+
+}
@@ -0,0 +1,243 @@
+#ifndef NEXUS_THREEFISH_HPP
+#define NEXUS_THREEFISH_HPP
+//Fully unrolled threefish 1024 for the nexus hash.
+//Lanes is a wrapper around a register type (a plain 64 bit integer or a simd register) providing
+//vec, lanes, set1, load, store, add, xor_, andnot and rol<bits>.  Each lane hashes a different nonce.
+//All round indices are template parameters so the rotation constants become immediates.
+//The word permutation is done by register renaming (the words are never moved) and the subkeys
+//are generated on the fly from the 17 word key and the tweak.
+//The nonce independent start of threefish2 is computed once per block (precomputeThreefish2).
+
+#include "hash/hash_constants.hpp"
+#include "lanes_scalar.hpp"
+#include <cstdint>
+#include <utility>
+
+namespace skein_lanes
+{
+namespace
+{
+
+//Instead of moving the words after every round we keep track of where each word lives.
+//slot(d, j) is the register holding word j at the start of round d.
+//The permutation has order 4 so at every subkey injection (and at the end) the words are in order.
+constexpr int slot(int d, int j)
+{
+    for (int i = 0; i < d % 4; i++)
+    {
+        j = SkeinConstants::permuteIndices[j];
+    }
+    return j;
+}
+
+//Only word 10 of message2 (the nonce) changes between hashes so the first rounds of threefish2
+//are partly the same for every nonce in a block.
+constexpr int nonceWord = 10;
+
+constexpr unsigned mixRegisters(int d, int j)
+{
+    return (1u << slot(d, 2 * j)) | (1u << slot(d, 2 * j + 1));
+}
+
+//bit mask of the registers that depend on the nonce at the start of round d
+constexpr unsigned nonceDependent(int d)
+{
+    unsigned mask = 1u << nonceWord;
+    for (int i = 0; i < d; i++)
+    {
+        for (int j = 0; j < SkeinConstants::numWords / 2; j++)
+        {
+            if (mask & mixRegisters(i, j))
+            {
+                mask |= mixRegisters(i, j);
+            }
+        }
+    }
+    return mask;
+}
+
+constexpr bool mixDependsOnNonce(int d, int j)
+{
+    return (nonceDependent(d) & mixRegisters(d, j)) != 0;
+}
+
+//number of rounds until every word depends on the nonce
+constexpr int countNonceRounds()
+{
+    int d = 0;
+    while (nonceDependent(d) != (1u << SkeinConstants::numWords) - 1)
+    {
+        d++;
+    }
+    return d;
+}
+
+template <typename Lanes>
+struct Threefish
+{
+    using vec = typename Lanes::vec;
+    static constexpr int numWords = SkeinConstants::numWords;
+    static constexpr int nonceRounds = countNonceRounds();
+    //the partial rounds must not cross a subkey injection
+    static_assert(nonceRounds <= 4, "threefish2 precompute spans a subkey injection");
+
+    template <int D, int J>
+    static inline void mix(vec (&v)[numWords])
+    {
+        constexpr int x0 = slot(D, 2 * J);
+        constexpr int x1 = slot(D, 2 * J + 1);
+        v[x0] = Lanes::add(v[x0], v[x1]);
+        v[x1] = Lanes::xor_(Lanes::template rol<SkeinConstants::R[D % 8][J]>(v[x1]), v[x0]);
+    }
+
+    //add subkey S.  Word i of subkey S is key[(S + i) % 17] plus the tweak for words 13 and 14 and S for word 15.
+    template <int S, int... I>
+    static inline void addSubkey(vec (&v)[numWords], const vec (&key)[numWords + 1], const uint64_t* tweak, std::integer_sequence<int, I...>)
+    {
+        ((v[I] = Lanes::add(v[I], key[(S + I) % (numWords + 1)])), ...);
+        v[numWords - 3] = Lanes::add(v[numWords - 3], Lanes::set1(tweak[S % 3]));
+        v[numWords - 2] = Lanes::add(v[numWords - 2], Lanes::set1(tweak[(S + 1) % 3]));
+        v[numWords - 1] = Lanes::add(v[numWords - 1], Lanes::set1(static_cast<uint64_t>(S)));
+    }
+
+    template <int D>
+    static inline void round(vec (&v)[numWords], const vec (&key)[numWords + 1], const uint64_t* tweak)
+    {
+        if constexpr (D % 4 == 0)
+        {
+            addSubkey<D / 4>(v, key, tweak, std::make_integer_sequence<int, numWords>{});
+        }
+        mix<D, 0>(v); mix<D, 1>(v); mix<D, 2>(v); mix<D, 3>(v);
+        mix<D, 4>(v); mix<D, 5>(v); mix<D, 6>(v); mix<D, 7>(v);
+    }
+
+    //rounds First to First + sizeof...(D) - 1
+    template <int First, int... D>
+    static inline void rounds(vec (&v)[numWords], const vec (&key)[numWords + 1], const uint64_t* tweak, std::integer_sequence<int, D...>)
+    {
+        (round<First + D>(v, key, tweak), ...);
+    }
+
+    //only the mixes of round D that do (Dependent = true) or do not depend on the nonce
+    template <int D, bool Dependent, int... J>
+    static inline void partialRound(vec (&v)[numWords], std::integer_sequence<int, J...>)
+    {
+        ((mixDependsOnNonce(D, J) == Dependent ? mix<D, J>(v) : void()), ...);
+    }
+
+    template <bool Dependent, int... D>
+    static inline void partialRounds(vec (&v)[numWords], std::integer_sequence<int, D...>)
+    {
+        (partialRound<D, Dependent>(v, std::make_integer_sequence<int, numWords / 2>{}), ...);
+    }
+
+    //encrypt v in place
+    static inline void threefish1024(vec (&v)[numWords], const vec (&key)[numWords + 1], const uint64_t* tweak)
+    {
+        rounds<0>(v, key, tweak, std::make_integer_sequence<int, SkeinConstants::numRounds>{});
+        addSubkey<SkeinConstants::subkeyCount - 1>(v, key, tweak, std::make_integer_sequence<int, numWords>{});
+    }
+
+    //Per block part of threefish2.  The first subkey is added to every word except the nonce and
+    //all mixes of the first rounds that are not touched by the nonce are done.
+    //midstate2 is the 16 word state to pass to calculateHash.
+    static inline void precomputeThreefish2(const uint64_t* key2, const uint64_t* message2, const uint64_t* tweak2, uint64_t* midstate2)
+    {
+        vec key[numWords + 1];
+        vec v[numWords];
+        for (int i = 0; i < numWords + 1; i++)
+        {
+            key[i] = Lanes::set1(key2[i]);
+        }
+        for (int i = 0; i < numWords; i++)
+        {
+            v[i] = Lanes::set1(i == nonceWord ? 0 : message2[i]);
+        }
+        addSubkey<0>(v, key, tweak2, std::make_integer_sequence<int, numWords>{});
+        partialRounds<false>(v, std::make_integer_sequence<int, nonceRounds>{});
+        for (int i = 0; i < numWords; i++)
+        {
+            Lanes::store(midstate2 + i * Lanes::lanes, v[i]);
+        }
+    }
+
+    //remainder of threefish2.  v is the precomputed midstate with the nonce added to the nonce word.
+    static inline void threefish2(vec (&v)[numWords], const vec (&key)[numWords + 1], const uint64_t* tweak2)
+    {
+        partialRounds<true>(v, std::make_integer_sequence<int, nonceRounds>{});
+        rounds<nonceRounds>(v, key, tweak2, std::make_integer_sequence<int, SkeinConstants::numRounds - nonceRounds>{});
+        addSubkey<SkeinConstants::subkeyCount - 1>(v, key, tweak2, std::make_integer_sequence<int, numWords>{});
+    }
+
+    //fill in the 17th key word
+    static inline void makeKey(vec (&key)[numWords + 1])
+    {
+        vec parity = Lanes::set1(SkeinConstants::C240);
+        for (int i = 0; i < numWords; i++)
+        {
+            parity = Lanes::xor_(parity, key[i]);
+        }
+        key[numWords] = parity;
+    }
+
+    //threefish2 and threefish3 starting from the per block midstate (see precomputeThreefish2).
+    //The nonces replace word 10 of message2.
+    static inline void skein(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+        const uint64_t* tweak2, const uint64_t* tweak3, const uint64_t* nonces, vec (&hash)[numWords])
+    {
+        vec key[numWords + 1];
+        vec message[numWords];
+        vec v[numWords];
+        for (int i = 0; i < numWords + 1; i++)
+        {
+            key[i] = Lanes::set1(key2[i]);
+        }
+        for (int i = 0; i < numWords; i++)
+        {
+            message[i] = Lanes::set1(message2[i]);
+            v[i] = Lanes::set1(midstate2[i]);
+        }
+        //the nonce is the only part of message2 that differs between lanes
+        message[nonceWord] = Lanes::load(nonces);
+        v[nonceWord] = Lanes::add(v[nonceWord], message[nonceWord]);
+
+        //second threefish call
+        threefish2(v, key, tweak2);
+
+        //the key for threefish3 is the threefish2 output xor message2
+        for (int i = 0; i < numWords; i++)
+        {
+            key[i] = Lanes::xor_(v[i], message[i]);
+        }
+        makeKey(key);
+
+        //third threefish call.  The message is all zeros.
+        for (int i = 0; i < numWords; i++)
+        {
+            v[i] = Lanes::set1(0);
+        }
+        threefish1024(v, key, tweak3);
+
+        for (int i = 0; i < numWords; i++)
+        {
+            hash[i] = v[i];
+        }
+    }
+
+    //same as skein but the hash of each lane is stored word major i.e. hashes[word * lanes + lane]
+    static inline void calculateHash(const uint64_t* midstate2, const uint64_t* key2, const uint64_t* message2,
+        const uint64_t* tweak2, const uint64_t* tweak3, const uint64_t* nonces, uint64_t* hashes)
+    {
+        vec hash[numWords];
+        skein(midstate2, key2, message2, tweak2, tweak3, nonces, hash);
+        for (int i = 0; i < numWords; i++)
+        {
+            Lanes::store(hashes + i * Lanes::lanes, hash[i]);
+        }
+    }
+};
+
+}
+}
+
+#endif
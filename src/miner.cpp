@@ -6,6 +6,7 @@
 #include "config/validator.hpp"
 #include "worker_manager.hpp"
 #include "worker.hpp"
+#include "cpu/thread_affinity.hpp"
 #include "version.h"
 
 #include <spdlog/spdlog.h>
@@ -130,6 +131,20 @@ namespace nexusminer
 			return;
 		}
 
+		//keep the io thread off the cpus of the mining threads
+		auto const io_thread_cpus = cpu::get_io_thread_cpus(m_config.get_worker_config(), *m_logger);
+		if (!io_thread_cpus.empty())
+		{
+			if (cpu::set_thread_affinity(io_thread_cpus))
+			{
+				m_logger->info("Pinning the io thread to cpus {}", cpu::format_cpu_list(io_thread_cpus));
+			}
+			else
+			{
+				m_logger->warn("Failed to pin the io thread to cpus {}", cpu::format_cpu_list(io_thread_cpus));
+			}
+		}
+
 		m_io_context->run();
 
 	}
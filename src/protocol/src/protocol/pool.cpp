@@ -135,24 +135,15 @@ void Pool::process_messages(Packet packet, std::shared_ptr<network::Connection>
 
 double Pool::get_hashrate_from_workers()
 {
-    double hashrate = 0.0;
-    auto const workers = m_stats_collector->get_workers_stats();
-    for (auto const& worker : workers)
+    // the short window so the pool sees changes in throughput within minutes
+    auto const rates = m_stats_collector->get_rates();
+    if (m_mining_mode == config::Mining_mode::HASH)
     {
-        if (m_mining_mode == config::Mining_mode::HASH)
-        {
-            auto& hash_stats = std::get<stats::Hash>(worker);
-            hashrate += (hash_stats.m_hash_count / static_cast<double>(m_stats_collector->get_elapsed_time_seconds().count())) / 1.0e6;
-        }
-        else
-        {
-            auto& prime_stats = std::get<stats::Prime>(worker);
-            //GISPS = Billion integers searched per second
-            hashrate += (prime_stats.m_range_searched / (1.0e9 * static_cast<double>(m_stats_collector->get_elapsed_time_seconds().count())));
-        }
+        // MH/s
+        return rates.m_1m / 1.0e6;
     }
-
-    return hashrate;
+    //GISPS = Billion integers searched per second
+    return rates.m_1m / 1.0e9;
 }
 
 }
@@ -0,0 +1,77 @@
+#ifndef NEXUSMINER_STATS_RATE_TRACKER_HPP
+#define NEXUSMINER_STATS_RATE_TRACKER_HPP
+
+#include "stats/types.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+namespace nexusminer {
+namespace stats
+{
+
+// Turns the cumulative progress counter of one worker (m_hash_count or m_range_searched) into rates.
+// The moving averages are exponentially weighted with exact decay for the irregular update interval.
+class Rate_tracker
+{
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    // time constants of the moving averages
+    static constexpr double short_window_seconds = 60.0;
+    static constexpr double long_window_seconds = 900.0;
+
+    // start is when the collector started.  The lifetime rate and the first measurement count from there.
+    explicit Rate_tracker(Clock::time_point start)
+    : m_start{start}
+    {
+    }
+
+    void update(std::uint64_t count, Clock::time_point now)
+    {
+        // the worker counts from 0 when it is created (at start or by the watchdog)
+        auto const last_count = m_last_count <= count ? m_last_count : 0;
+        auto const last_update = m_started ? m_last_update : m_start;
+        double const seconds = std::chrono::duration<double>(now - last_update).count();
+        if (seconds <= 0.0)
+        {
+            return;
+        }
+        auto const delta = count - last_count;
+        double const rate = delta / seconds;
+        m_total += delta;
+        if (!m_started)
+        {
+            // no history.  Start the averages at the first measurement instead of ramping up from 0.
+            m_rates.m_1m = rate;
+            m_rates.m_15m = rate;
+            m_started = true;
+        }
+        else
+        {
+            m_rates.m_1m += (1.0 - std::exp(-seconds / short_window_seconds)) * (rate - m_rates.m_1m);
+            m_rates.m_15m += (1.0 - std::exp(-seconds / long_window_seconds)) * (rate - m_rates.m_15m);
+        }
+        double const elapsed = std::chrono::duration<double>(now - m_start).count();
+        m_rates.m_lifetime = elapsed > 0.0 ? m_total / elapsed : 0.0;
+        m_last_count = count;
+        m_last_update = now;
+    }
+
+    Rates const& get_rates() const { return m_rates; }
+
+private:
+
+    Clock::time_point m_start;
+    std::uint64_t m_last_count{ 0 };
+    Clock::time_point m_last_update{};
+    // progress since start.  Survives the counter starting over (worker recreated).
+    std::uint64_t m_total{ 0 };
+    bool m_started{ false };
+    Rates m_rates{};
+};
+
+}
+}
+#endif
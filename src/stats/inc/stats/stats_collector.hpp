@@ -2,6 +2,7 @@
 #define NEXUSMINER_STATS_COLLECTOR_HPP
 
 #include "stats/types.hpp"
+#include "stats/rate_tracker.hpp"
 #include <memory>
 #include <vector>
 #include <variant>
@@ -29,18 +30,24 @@ public:
 
     Global get_global_stats() const { return m_global_stats; }
 
+    // windowed rates of the progress counter of a worker (m_hash_count or m_range_searched)
+    Rates get_worker_rates(std::uint32_t internal_worker_id) const;
+    // sum over all workers
+    Rates get_rates() const;
+
 
 private:
 
     config::Config& m_config;
     std::vector<std::variant<Hash, Prime>> m_workers;
+    std::vector<Rate_tracker> m_worker_rates;
 
     Global m_global_stats;
     std::chrono::steady_clock::time_point m_start_time;
 
     // worker stats are updated in seperate worker threads
     // the access to the worker data (form stats_printer) has to be protected
-    std::mutex m_worker_mutex;
+    mutable std::mutex m_worker_mutex;
 
 
 };
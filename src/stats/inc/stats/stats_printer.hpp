@@ -3,6 +3,7 @@
 
 #include "stats_collector.hpp"
 #include "stats/types.hpp"
+#include "config/types.hpp"
 #include <string>
 #include <sstream>
 #include <iostream>
@@ -20,6 +21,17 @@ public:
     virtual void print() = 0;
 };
 
+// "1.23/1.20/1.18 MH/s (1m/15m/avg)".  GISPS = Billion integers searched per second
+inline std::string format_rates(config::Mining_mode mining_mode, Rates const& rates)
+{
+    bool const hash = mining_mode == config::Mining_mode::HASH;
+    double const unit = hash ? 1.0e6 : 1.0e9;
+    std::stringstream ss;
+    ss << std::setprecision(2) << std::fixed << rates.m_1m / unit << "/" << rates.m_15m / unit << "/" << rates.m_lifetime / unit
+        << (hash ? " MH/s" : " GISPS") << " (1m/15m/avg)";
+    return ss.str();
+}
+
 class Printer_solo
 {
 public:
@@ -32,7 +44,12 @@ public:
         ss << "Hours elapsed: " << stats_collector.get_elapsed_time_seconds().count() / 3600.0;
         ss << " Blocks accepted: " << global_stats.m_accepted_blocks
             << " rejected: " << global_stats.m_rejected_blocks;
-        ss << " Connection retries: " << global_stats.m_connection_retries << std::endl;
+        ss << " Connection retries: " << global_stats.m_connection_retries;
+        if (global_stats.m_worker_recoveries != 0)
+            ss << " Worker recoveries: " << global_stats.m_worker_recoveries;
+        if (global_stats.m_workers_lost != 0)
+            ss << " Workers lost: " << global_stats.m_workers_lost;
+        ss << std::endl;
 
         return ss.str();
     }
@@ -50,7 +67,12 @@ public:
         ss << "Hours elapsed: " << stats_collector.get_elapsed_time_seconds().count() / 3600.0;
         ss << " Shares accepted: " << global_stats.m_accepted_shares
             << " rejected: " << global_stats.m_rejected_shares;
-        ss << " Connection retries: " << global_stats.m_connection_retries << std::endl;
+        ss << " Connection retries: " << global_stats.m_connection_retries;
+        if (global_stats.m_worker_recoveries != 0)
+            ss << " Worker recoveries: " << global_stats.m_worker_recoveries;
+        if (global_stats.m_workers_lost != 0)
+            ss << " Workers lost: " << global_stats.m_workers_lost;
+        ss << std::endl;
 
         return ss.str();
     }
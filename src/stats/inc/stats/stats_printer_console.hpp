@@ -52,6 +52,7 @@ inline void Printer_console<PrinterType>::print()
     auto const workers = m_stats_collector.get_workers_stats();
     std::stringstream ss;
     ss << globals_string;
+    ss << "Total: " << format_rates(m_mining_mode, m_stats_collector.get_rates()) << std::endl;
 
     auto worker_config_index = 0U;
     for (auto const& worker : workers)
@@ -61,19 +62,25 @@ inline void Printer_console<PrinterType>::print()
         if (m_mining_mode == config::Mining_mode::HASH)
         {
             auto& hash_stats = std::get<Hash>(worker);
-            ss << std::setprecision(2) << std::fixed << (hash_stats.m_hash_count / static_cast<double>(m_stats_collector.get_elapsed_time_seconds().count())) / 1.0e6 << "MH/s. ";
+            ss << format_rates(m_mining_mode, m_stats_collector.get_worker_rates(worker_config_index)) << ". ";
+            ss << std::setprecision(2) << std::fixed;
             ss << (m_worker_config[worker_config_index].m_mode == config::Worker_mode::FPGA ? hash_stats.m_nonce_candidates_recieved : hash_stats.m_met_difficulty_count)
                 << " candidates found. Most difficult: " << hash_stats.m_best_leading_zeros;
-            if (m_worker_config[worker_config_index].m_mode == config::Worker_mode::FPGA)
+            //cpu and gpu workers only report errors when the kernel disagrees with the reference hash
+            if (m_worker_config[worker_config_index].m_mode == config::Worker_mode::FPGA || hash_stats.m_hash_error_count != 0)
                 ss << " Hash Errors: " << hash_stats.m_hash_error_count;
+            if (hash_stats.m_max_block_switch_us != 0)
+                ss << " Block switch p50/p99/max: " << hash_stats.m_block_switch_p50_us / 1000.0 << "/" << hash_stats.m_block_switch_p99_us / 1000.0
+                    << "/" << hash_stats.m_max_block_switch_us / 1000.0 << "ms";
+            if (!hash_stats.m_placement.empty())
+                ss << " Placement: " << hash_stats.m_placement;
 
         }
         else
         {
             auto& prime_stats = std::get<Prime>(worker);
+            ss << format_rates(m_mining_mode, m_stats_collector.get_worker_rates(worker_config_index)) << " ";
             ss << std::setprecision(2) << std::fixed;
-            //GISPS = Billion integers searched per second
-            ss << (prime_stats.m_range_searched / (1.0e9 * static_cast<double>(m_stats_collector.get_elapsed_time_seconds().count()))) << " GISPS ";
             ss << "Chain Count: ";
             for (auto i=5; i< prime_stats.m_chain_histogram.size(); i++)
             {
@@ -81,6 +88,11 @@ inline void Printer_console<PrinterType>::print()
             }
             ss << " Best " << prime_stats.m_most_difficult_chain;
             ss << " Current Difficulty " << prime_stats.m_difficulty / 10000000.0;
+            if (prime_stats.m_max_block_switch_us != 0)
+                ss << " Block switch p50/p99/max: " << prime_stats.m_block_switch_p50_us / 1000.0 << "/" << prime_stats.m_block_switch_p99_us / 1000.0
+                    << "/" << prime_stats.m_max_block_switch_us / 1000.0 << "ms";
+            if (!prime_stats.m_placement.empty())
+                ss << " Placement: " << prime_stats.m_placement;
         }
         worker_config_index++;
         if (worker_config_index < workers.size())
@@ -1,12 +1,14 @@
 #ifndef NEXUSMINER_STATS_TYPES_HPP
 #define NEXUSMINER_STATS_TYPES_HPP
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <array>
 #include <variant>
 #include <chrono>
 #include <mutex>
+#include <string>
 
 namespace nexusminer {
 namespace stats
@@ -19,6 +21,10 @@ struct Global
     std::uint32_t m_accepted_shares{ 0 };
     std::uint32_t m_rejected_shares{ 0 };
     std::uint32_t m_connection_retries{ 0 };
+    // stalled workers that got their work reissued or were recreated by the watchdog
+    std::uint32_t m_worker_recoveries{ 0 };
+    // stalled workers that didn't shut down to be recreated
+    std::uint32_t m_workers_lost{ 0 };
 
     Global& operator+=(Global const& other)
     {
@@ -27,6 +33,8 @@ struct Global
         m_accepted_shares += other.m_accepted_shares;
         m_rejected_shares += other.m_rejected_shares;
         m_connection_retries += other.m_connection_retries;
+        m_worker_recoveries += other.m_worker_recoveries;
+        m_workers_lost += other.m_workers_lost;
 
         return *this;
     }
@@ -39,25 +47,24 @@ struct Hash
     int m_met_difficulty_count{0};
     int m_nonce_candidates_recieved{0};
     int m_hash_error_count{0};
-
-    Hash() = default;
-
-    Hash(Hash const& other)
-    {
-        m_hash_count = other.m_hash_count;
-        m_best_leading_zeros = other.m_best_leading_zeros;
-        m_met_difficulty_count = other.m_met_difficulty_count;
-        m_nonce_candidates_recieved = other.m_nonce_candidates_recieved;
-        m_hash_error_count = other.m_hash_error_count;
-    }
+    //time from receiving a block until every mining thread works on it.  Over the latest blocks.
+    std::uint32_t m_block_switch_p50_us{0};
+    std::uint32_t m_block_switch_p99_us{0};
+    std::uint32_t m_max_block_switch_us{0};
+    //cpus the mining threads are pinned to.  empty if not pinned
+    std::string m_placement{};
 
     Hash& operator+=(Hash const& other)
     {
         m_hash_count += other.m_hash_count;
-        m_best_leading_zeros += std::max(m_best_leading_zeros, other.m_best_leading_zeros);
+        m_best_leading_zeros = std::max(m_best_leading_zeros, other.m_best_leading_zeros);
         m_met_difficulty_count += other.m_met_difficulty_count;
         m_nonce_candidates_recieved += other.m_nonce_candidates_recieved;
-        m_hash_error_count += m_hash_error_count;
+        m_hash_error_count += other.m_hash_error_count;
+        //the pool switches when its slowest worker switches
+        m_block_switch_p50_us = std::max(m_block_switch_p50_us, other.m_block_switch_p50_us);
+        m_block_switch_p99_us = std::max(m_block_switch_p99_us, other.m_block_switch_p99_us);
+        m_max_block_switch_us = std::max(m_max_block_switch_us, other.m_max_block_switch_us);
         return *this;
     }
 };
@@ -70,9 +77,48 @@ struct Prime
     std::uint64_t m_range_searched { 0 };
     double m_most_difficult_chain{ 0.0 };
     std::vector<std::uint32_t> m_chain_histogram{0,0,0,0,0,0,0,0,0,0};
+    //time from receiving a block until the worker mines it.  Over the latest blocks.
+    std::uint32_t m_block_switch_p50_us{0};
+    std::uint32_t m_block_switch_p99_us{0};
+    std::uint32_t m_max_block_switch_us{0};
+    //cpus the mining thread is pinned to.  empty if not pinned
+    std::string m_placement{};
 
     Prime& operator+=(Prime const& other)
     {
+        m_primes += other.m_primes;
+        m_chains += other.m_chains;
+        m_difficulty = std::max(m_difficulty, other.m_difficulty);
+        m_range_searched += other.m_range_searched;
+        m_most_difficult_chain = std::max(m_most_difficult_chain, other.m_most_difficult_chain);
+        if (m_chain_histogram.size() < other.m_chain_histogram.size())
+        {
+            m_chain_histogram.resize(other.m_chain_histogram.size(), 0);
+        }
+        for (std::size_t i = 0; i < other.m_chain_histogram.size(); i++)
+        {
+            m_chain_histogram[i] += other.m_chain_histogram[i];
+        }
+        m_block_switch_p50_us = std::max(m_block_switch_p50_us, other.m_block_switch_p50_us);
+        m_block_switch_p99_us = std::max(m_block_switch_p99_us, other.m_block_switch_p99_us);
+        m_max_block_switch_us = std::max(m_max_block_switch_us, other.m_max_block_switch_us);
+        return *this;
+    }
+};
+
+// Throughput of a worker or of all workers.  Hashes per second (hash channel) or integers searched per second (prime channel).
+// m_1m and m_15m are exponentially weighted moving averages with a time constant of 1 and 15 minutes.
+struct Rates
+{
+    double m_1m{ 0.0 };
+    double m_15m{ 0.0 };
+    double m_lifetime{ 0.0 };
+
+    Rates& operator+=(Rates const& other)
+    {
+        m_1m += other.m_1m;
+        m_15m += other.m_15m;
+        m_lifetime += other.m_lifetime;
         return *this;
     }
 };
@@ -6,7 +6,6 @@ namespace nexusminer
 {
 namespace stats
 {
-
 Collector::Collector(config::Config& config)
 : m_config{config}
 , m_start_time{std::chrono::steady_clock::now()}
@@ -22,6 +21,7 @@ Collector::Collector(config::Config& config)
             m_workers.push_back(Prime{});
         }
     }
+    m_worker_rates.resize(m_workers.size(), Rate_tracker{m_start_time});
 }
 
 void Collector::update_global_stats(Global const& stats)
@@ -37,6 +37,7 @@ void Collector::update_worker_stats(std::uint16_t internal_worker_id, Hash const
 
     auto& hash_stats = std::get<Hash>(m_workers[internal_worker_id]);
     hash_stats = stats;
+    m_worker_rates[internal_worker_id].update(stats.m_hash_count, std::chrono::steady_clock::now());
 }
 
 void Collector::update_worker_stats(std::uint16_t internal_worker_id, Prime const& stats)
@@ -47,6 +48,24 @@ void Collector::update_worker_stats(std::uint16_t internal_worker_id, Prime cons
     
     auto& prime_stats = std::get<Prime>(m_workers[internal_worker_id]);
     prime_stats = stats;
+    m_worker_rates[internal_worker_id].update(stats.m_range_searched, std::chrono::steady_clock::now());
+}
+
+Rates Collector::get_worker_rates(std::uint32_t internal_worker_id) const
+{
+    std::scoped_lock lock(m_worker_mutex);
+    return m_worker_rates[internal_worker_id].get_rates();
+}
+
+Rates Collector::get_rates() const
+{
+    std::scoped_lock lock(m_worker_mutex);
+    Rates rates{};
+    for (auto const& worker_rates : m_worker_rates)
+    {
+        rates += worker_rates.get_rates();
+    }
+    return rates;
 }
 
 }
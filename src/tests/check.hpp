@@ -0,0 +1,35 @@
+#ifndef NEXUSMINER_TESTS_CHECK_HPP
+#define NEXUSMINER_TESTS_CHECK_HPP
+
+#include <iostream>
+
+namespace nexusminer {
+namespace test {
+
+// Minimal checks for the unit tests.  A failed check prints where it failed, the test goes on and returns non zero at the end.
+inline int& failures()
+{
+    static int count = 0;
+    return count;
+}
+
+inline void check(bool condition, char const* expression, char const* file, int line)
+{
+    if (!condition)
+    {
+        std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+        failures()++;
+    }
+}
+
+inline int result()
+{
+    return failures() == 0 ? 0 : 1;
+}
+
+}
+}
+
+#define CHECK(expression) ::nexusminer::test::check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
+
+#endif
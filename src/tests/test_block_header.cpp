@@ -0,0 +1,68 @@
+#include "check.hpp"
+#include "worker.hpp"
+#include "LLC/hash/SK.h"
+#include "LLC/hash/macro.h"
+#include "LLC/types/uint1024.h"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace nexusminer {
+namespace {
+
+// distinct bytes in every limb so a swapped or reversed limb changes the hash
+template<typename T>
+T random_uint(std::mt19937_64& random)
+{
+    std::vector<std::uint8_t> bytes(sizeof(T));
+    for (auto& byte : bytes)
+    {
+        byte = static_cast<std::uint8_t>(random());
+    }
+    return T{ bytes };
+}
+
+Block_data random_block(std::mt19937_64& random)
+{
+    Block_data block;
+    block.nVersion = static_cast<std::uint32_t>(random());
+    block.previous_hash = random_uint<uint1024_t>(random);
+    block.merkle_root = random_uint<uint512_t>(random);
+    block.nChannel = static_cast<std::uint32_t>(random());
+    block.nHeight = static_cast<std::uint32_t>(random());
+    block.nBits = static_cast<std::uint32_t>(random());
+    block.nNonce = random();
+    return block;
+}
+
+// the header bytes hash the same as the raw struct the gpu worker hashes
+void test_header_matches_struct()
+{
+    std::mt19937_64 random{ 13 };
+    for (int i = 0; i < 8; i++)
+    {
+        auto const block = random_block(random);
+        Block_data::Header_bytes header;
+
+        CHECK(block.WriteHeaderBytes(header) == Block_data::header_length);
+        CHECK(LLC::SK1024(header.begin(), header.end()) == LLC::SK1024(BEGIN(block.nVersion), END(block.nNonce)));
+
+        auto const length = block.WriteHeaderBytes(header, true);
+        CHECK(length == Block_data::header_length_prime);
+        CHECK(LLC::SK1024(header.begin(), header.begin() + length) == LLC::SK1024(BEGIN(block.nVersion), END(block.nBits)));
+
+        auto const bytes = block.GetHeaderBytes();
+        CHECK(std::vector<unsigned char>(header.begin(), header.begin() + length) == block.GetHeaderBytes(true));
+        CHECK(bytes.size() == Block_data::header_length);
+        CHECK(LLC::SK1024(bytes.begin(), bytes.end()) == LLC::SK1024(BEGIN(block.nVersion), END(block.nNonce)));
+    }
+}
+
+}
+}
+
+int main()
+{
+    nexusminer::test_header_matches_struct();
+    return nexusminer::test::result();
+}
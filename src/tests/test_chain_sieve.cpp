@@ -0,0 +1,237 @@
+#include "check.hpp"
+#include "prime/chain_sieve.hpp"
+#include "cpu/cache_sizes.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <primesieve.hpp>
+#include <spdlog/spdlog.h>
+
+namespace nexusminer {
+namespace {
+
+using boost::multiprecision::uint1024_t;
+
+constexpr int wheel_offsets[8] = { 1, 7, 11, 13, 17, 19, 23, 29 };
+//the sieve's limits
+constexpr std::uint32_t sieving_start_prime = 7;
+constexpr std::uint32_t sieving_prime_limit = 300000000;
+constexpr int min_chain_length = 8;
+
+// The plain byte sieve: every sieving prime crosses off each of its multiples in the segment one by one.
+// No pre-sieve patterns, blocks or buckets.
+class Reference_sieve
+{
+public:
+
+    explicit Reference_sieve(uint1024_t const& sieve_start)
+    {
+        primesieve::generate_primes(sieving_start_prime, sieving_prime_limit, &m_primes);
+        m_residues.reserve(m_primes.size());
+        for (auto p : m_primes)
+        {
+            m_residues.push_back(static_cast<std::uint32_t>(sieve_start % p));
+        }
+        for (int bit = 0; bit < 8; bit++)
+        {
+            m_bit[wheel_offsets[bit]] = bit;
+        }
+    }
+
+    // bytes of the integers [sieve_start + low, sieve_start + low + 30 * size)
+    std::vector<std::uint8_t> segment(std::uint64_t low, std::size_t size) const
+    {
+        std::vector<std::uint8_t> sieve(size, 0xFF);
+        std::uint64_t const end = 30ULL * size;
+        for (std::size_t i = 0; i < m_primes.size(); i++)
+        {
+            std::uint64_t const p = m_primes[i];
+            std::uint64_t const remainder = (m_residues[i] + low % p) % p;
+            for (std::uint64_t j = (p - remainder) % p; j < end; j += p)
+            {
+                int const bit = m_bit[j % 30];
+                if (bit >= 0)
+                {
+                    sieve[j / 30] &= static_cast<std::uint8_t>(~(1 << bit));
+                }
+            }
+        }
+        return sieve;
+    }
+
+private:
+
+    std::vector<std::uint32_t> m_primes;
+    std::vector<std::uint32_t> m_residues;
+    int m_bit[30] = { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 };
+};
+
+using Chain_candidates = std::vector<std::vector<std::uint64_t>>;
+
+// candidates closer than the max gap form a chain.  Chains of at least min_chain_length are kept.
+Chain_candidates reference_chains(std::vector<std::uint8_t> const& sieve)
+{
+    Chain_candidates chains;
+    std::vector<std::uint64_t> chain;
+    auto close = [&chains, &chain]()
+    {
+        if (chain.size() >= min_chain_length)
+        {
+            chains.push_back(chain);
+        }
+        chain.clear();
+    };
+    for (std::size_t n = 0; n < sieve.size(); n++)
+    {
+        for (int bit = 0; bit < 8; bit++)
+        {
+            if (sieve[n] & (1 << bit))
+            {
+                std::uint64_t const candidate = 30ULL * n + wheel_offsets[bit];
+                if (!chain.empty() && candidate - chain.back() > cpu::maxGap)
+                {
+                    close();
+                }
+                chain.push_back(candidate);
+            }
+        }
+    }
+    close();
+    return chains;
+}
+
+void add_chains(cpu::Sieve const& sieve, std::uint64_t sieve_offset, Chain_candidates& chains)
+{
+    for (auto const& chain : sieve.get_chains())
+    {
+        std::vector<std::uint64_t> candidates;
+        for (auto const& offset : chain.m_offsets)
+        {
+            candidates.push_back(sieve_offset + chain.m_base_offset + offset.m_offset);
+        }
+        chains.push_back(std::move(candidates));
+    }
+}
+
+// small caches so the segments are short and most sieving primes go through the buckets
+cpu::Cache_sizes const test_cache_sizes{ 16384, 65536 };
+constexpr int segments = 4;
+
+// the distance from the reference start to a sieve start that puts a chain across the boundary at chunk_size
+std::uint64_t chain_across_boundary(Reference_sieve const& reference, std::uint64_t chunk_size)
+{
+    constexpr std::size_t window_size = 4096;
+    for (std::uint64_t low = chunk_size; ; low += 30 * window_size)
+    {
+        for (auto const& chain : reference_chains(reference.segment(low, window_size)))
+        {
+            std::uint64_t const boundary = chain.back() / 30 * 30;
+            if (chain.front() < boundary)
+            {
+                return low + boundary - chunk_size;
+            }
+        }
+    }
+}
+
+void test_segments_match_reference(cpu::Sieve& sieve, Reference_sieve const& reference, uint1024_t const& reference_start,
+    std::uint64_t shift, Chain_candidates& expected_chains)
+{
+    sieve.set_sieve_start(reference_start + shift);
+    sieve.calculate_starting_multiples();
+    sieve.clear_chains();
+    std::uint64_t const segment_size = sieve.get_segment_size();
+    std::vector<std::uint8_t> all_bytes;
+    bool bytes_match = true;
+    for (int segment = 0; segment < segments; segment++)
+    {
+        std::uint64_t const low = segment * segment_size;
+        sieve.reset_sieve();
+        sieve.sieve_segment();
+        auto const expected = reference.segment(shift + low, sieve.get_sieve().size());
+        bytes_match = bytes_match && sieve.get_sieve() == expected;
+        all_bytes.insert(all_bytes.end(), expected.begin(), expected.end());
+        sieve.find_chains(low, false);
+    }
+    //the end of the range closes the open chain
+    sieve.finish_chains({}, segments * segment_size);
+    CHECK(bytes_match);
+
+    expected_chains = reference_chains(all_bytes);
+    Chain_candidates chains;
+    add_chains(sieve, 0, chains);
+    CHECK(!expected_chains.empty());
+    CHECK(chains == expected_chains);
+}
+
+// two threads sieve consecutive chunks.  The lower one finishes its chains with the handoff of the upper one.
+void test_chunks_match_single_sieve(cpu::Sieve& lower, cpu::Sieve& upper, uint1024_t const& sieve_start,
+    std::uint64_t chunk_size, Chain_candidates const& expected_chains)
+{
+    std::uint64_t const segment_size = lower.get_segment_size();
+    lower.set_sieve_start(sieve_start);
+    lower.calculate_starting_multiples();
+    lower.clear_chains();
+    upper.set_sieve_start(sieve_start + chunk_size);
+    upper.calculate_starting_multiples();
+    upper.clear_chains();
+
+    std::vector<std::uint8_t> handoff;
+    for (std::uint64_t low = 0; low < chunk_size; low += segment_size)
+    {
+        upper.reset_sieve();
+        upper.sieve_segment();
+        std::uint64_t first_byte = 0;
+        if (low == 0)
+        {
+            handoff = upper.get_chain_handoff();
+            first_byte = handoff.size();
+        }
+        upper.find_chains(low, false, first_byte);
+    }
+    upper.finish_chains({}, chunk_size);
+    for (std::uint64_t low = 0; low < chunk_size; low += segment_size)
+    {
+        lower.reset_sieve();
+        lower.sieve_segment();
+        lower.find_chains(low, false);
+    }
+    lower.finish_chains(handoff, chunk_size);
+
+    Chain_candidates chains;
+    add_chains(lower, 0, chains);
+    add_chains(upper, chunk_size, chains);
+    std::sort(chains.begin(), chains.end());
+    CHECK(chains == expected_chains);
+}
+
+}
+}
+
+int main()
+{
+    using namespace nexusminer;
+    //the sieve logs to the miner's logger
+    auto logger = spdlog::default_logger()->clone("logger");
+    logger->set_level(spdlog::level::off);
+    spdlog::register_logger(logger);
+
+    //a 1024 bit start like the prime channel's base hash.  Rounded up to a multiple of 30 by the sieve.
+    cpu::Sieve sieve{ test_cache_sizes };
+    sieve.generate_sieving_primes();
+    sieve.set_sieve_start((uint1024_t{ 1 } << 1023) + 0x123456789abcdefULL);
+    uint1024_t const reference_start = sieve.get_sieve_start();
+    Reference_sieve const reference{ reference_start };
+    std::uint64_t const chunk_size = segments / 2 * sieve.get_segment_size();
+    std::uint64_t const shift = chain_across_boundary(reference, chunk_size);
+
+    Chain_candidates expected_chains;
+    test_segments_match_reference(sieve, reference, reference_start, shift, expected_chains);
+
+    cpu::Sieve upper{ test_cache_sizes };
+    upper.share_sieving_primes(sieve);
+    test_chunks_match_single_sieve(sieve, upper, reference_start + shift, chunk_size, expected_chains);
+
+    return test::result();
+}
@@ -0,0 +1,187 @@
+#include "check.hpp"
+#include "hash/hash_kernels.hpp"
+#include "hash/nexus_skein.hpp"
+#include "hash/nexus_keccak.hpp"
+#include "LLC/hash/SK.h"
+#include "LLC/types/uint1024.h"
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace nexusminer {
+namespace {
+
+constexpr std::size_t header_length = 216;
+//the prime channel hashes the header without the nonce
+constexpr std::size_t header_length_prime = 208;
+constexpr int headers = 4;
+//the candidate buffer of one hashRange call holds 64.  A range where every nonce is a candidate crosses it a few times.
+constexpr std::uint64_t batch_size = 64;
+
+std::vector<unsigned char> random_header(std::mt19937_64& random, std::size_t length)
+{
+    std::vector<unsigned char> header(length);
+    for (auto& byte : header)
+    {
+        byte = static_cast<unsigned char>(random());
+    }
+    return header;
+}
+
+// the top 64 bits of LLC::SK1024 (skein + keccak) with the nonce in the last 8 bytes of the header, little endian
+std::uint64_t reference_result(std::vector<unsigned char> header, std::uint64_t nonce)
+{
+    auto const nonce_offset = header.size() - 8;
+    for (std::size_t i = 0; i < 8; i++)
+    {
+        header[nonce_offset + i] = static_cast<unsigned char>(nonce >> (8 * i));
+    }
+    return LLC::SK1024(header.begin(), header.end()).Get64(15);
+}
+
+// nonces at the edges of the lanes: both sides of 32 bit carries and the 64 bit wrap
+std::vector<std::uint64_t> boundary_nonces(std::mt19937_64& random)
+{
+    std::vector<std::uint64_t> nonces{ 0, 1, 7, 8, 9, 0xFFFFFFFFull, 0x100000000ull, ~0ull - 8, ~0ull - 1, ~0ull };
+    for (int i = 0; i < 16; i++)
+    {
+        nonces.push_back(random());
+    }
+    return nonces;
+}
+
+// the scalar full hash: midstate, skein and the untruncated keccak
+void test_full_hash(std::vector<unsigned char> const& header)
+{
+    NexusSkein skein{ header };
+    skein.calculateHash();
+    NexusKeccak keccak{ skein.getHash() };
+    keccak.calculateHash();
+    CHECK(keccak.getResult() == LLC::SK1024(header.begin(), header.end()).Get64(15));
+    CHECK(NexusKeccak{ skein.getHash() }.calculateResult() == keccak.getResult());
+}
+
+void test_calculate_result(HashKernel const& kernel, NexusSkein const& skein, std::vector<unsigned char> const& header,
+    std::vector<std::uint64_t> const& nonces)
+{
+    std::vector<std::uint64_t> lane_nonces(kernel.lanes);
+    std::vector<std::uint64_t> results(kernel.lanes);
+    bool match = true;
+    for (std::size_t i = 0; i < nonces.size(); i++)
+    {
+        //each nonce in every lane so a lane that mixes up its neighbour shows up
+        for (int lane = 0; lane < kernel.lanes; lane++)
+        {
+            lane_nonces[lane] = nonces[(i + lane) % nonces.size()];
+        }
+        (skein.*kernel.calculateResult)(lane_nonces.data(), results.data());
+        for (int lane = 0; lane < kernel.lanes; lane++)
+        {
+            match = match && results[lane] == reference_result(header, lane_nonces[lane]);
+        }
+    }
+    CHECK(match);
+}
+
+std::vector<NexusSkein::Candidate> reference_range(std::vector<unsigned char> const& header, std::uint64_t first_nonce,
+    std::uint64_t count, std::uint64_t threshold)
+{
+    std::vector<NexusSkein::Candidate> candidates;
+    for (std::uint64_t i = 0; i < count; i++)
+    {
+        auto const result = reference_result(header, first_nonce + i);
+        if (result <= threshold)
+        {
+            candidates.push_back({ first_nonce + i, result });
+        }
+    }
+    return candidates;
+}
+
+bool same_candidates(std::vector<NexusSkein::Candidate> const& a, std::vector<NexusSkein::Candidate> const& b)
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+        [](NexusSkein::Candidate const& x, NexusSkein::Candidate const& y) { return x.nonce == y.nonce && x.result == y.result; });
+}
+
+void test_hash_range(HashKernel const& kernel, NexusSkein const& skein, std::vector<unsigned char> const& header)
+{
+    std::uint64_t const lanes = kernel.lanes;
+    //ranges that start and end off the lane grid, over the 32 bit carry and up to the 64 bit wrap
+    struct Range { std::uint64_t m_first; std::uint64_t m_count; };
+    Range const ranges[] = { { 0, 1 }, { 3, lanes - 1 }, { 5, 2 * lanes + 1 }, { 0xFFFFFFFFull - lanes, 2 * lanes + 3 },
+        { ~0ull - 3 * lanes, 3 * lanes + 1 } };
+    for (auto const& range : ranges)
+    {
+        std::vector<NexusSkein::Candidate> candidates;
+        (skein.*kernel.hashRange)(range.m_first, range.m_count, ~0ull, candidates);
+        CHECK(same_candidates(candidates, reference_range(header, range.m_first, range.m_count, ~0ull)));
+    }
+
+    //every nonce is a candidate so the kernel stops and restarts at each full candidate buffer
+    std::uint64_t const first = 1000 + 1;
+    std::uint64_t const count = 3 * batch_size + lanes + 1;
+    std::vector<NexusSkein::Candidate> all;
+    (skein.*kernel.hashRange)(first, count, ~0ull, all);
+    auto const expected = reference_range(header, first, count, ~0ull);
+    CHECK(same_candidates(all, expected));
+
+    //thresholds at a result: the result is in at the threshold and out one below it
+    std::vector<std::uint64_t> results;
+    for (auto const& candidate : expected)
+    {
+        results.push_back(candidate.result);
+    }
+    std::sort(results.begin(), results.end());
+    for (auto const threshold : { results[0], results[1], results[count / 2] })
+    {
+        for (auto const filter : { threshold, threshold - 1 })
+        {
+            std::vector<NexusSkein::Candidate> candidates;
+            (skein.*kernel.hashRange)(first, count, filter, candidates);
+            CHECK(same_candidates(candidates, reference_range(header, first, count, filter)));
+        }
+    }
+}
+
+// the prime header has no nonce.  The kernels hash it with nonce 0 in the padding.
+void test_prime_header(HashKernel const& kernel, std::vector<unsigned char> const& header)
+{
+    NexusSkein const skein{ header };
+    std::vector<std::uint64_t> const nonces(kernel.lanes, 0);
+    std::vector<std::uint64_t> results(kernel.lanes);
+    (skein.*kernel.calculateResult)(nonces.data(), results.data());
+    std::uint64_t const expected = LLC::SK1024(header.begin(), header.end()).Get64(15);
+    CHECK(std::all_of(results.begin(), results.end(), [expected](std::uint64_t result) { return result == expected; }));
+}
+
+}
+}
+
+int main()
+{
+    using namespace nexusminer;
+    std::mt19937_64 random{ 0x5eed };
+    auto const nonces = boundary_nonces(random);
+    for (int i = 0; i < headers; i++)
+    {
+        auto const header = random_header(random, header_length);
+        auto const prime_header = random_header(random, header_length_prime);
+        test_full_hash(header);
+        test_full_hash(prime_header);
+        NexusSkein const skein{ header };
+        for (auto const& kernel : getHashKernels())
+        {
+            //kernels for instruction sets this cpu lacks can't run here
+            if (!kernel.supported)
+            {
+                continue;
+            }
+            test_calculate_result(kernel, skein, header, nonces);
+            test_hash_range(kernel, skein, header);
+            test_prime_header(kernel, prime_header);
+        }
+    }
+    return test::result();
+}
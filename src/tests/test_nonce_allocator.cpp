@@ -0,0 +1,120 @@
+#include "check.hpp"
+#include "nonce_allocator.hpp"
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace nexusminer {
+namespace {
+
+using namespace std::chrono_literals;
+
+void test_leases_never_overlap()
+{
+    Nonce_allocator allocator;
+    //a hash thread, a prime thread (segment * threads, a multiple of 30) and a device with a fixed lease
+    auto const hash = allocator.add_consumer(256, 1000, 0ms);
+    auto const prime = allocator.add_consumer(30 * 7, 3 * 30 * 7, 0ms);
+    auto const device = allocator.add_consumer(1, 1234, 0ms);
+    auto const granularity = std::vector<std::uint64_t>{ 256, 30 * 7, 1 };
+
+    std::vector<Nonce_allocator::Lease> leases;
+    for (int i = 0; i < 50; i++)
+    {
+        auto const consumer = static_cast<std::size_t>(i % 3);
+        auto const lease = consumer == device ? allocator.lease(device, 1234) : allocator.lease(consumer == hash ? hash : prime);
+        //starts and sizes follow the granularity so a sieve that rounds its start moves every lease the same
+        CHECK(lease.m_first % granularity[consumer] == 0);
+        CHECK(lease.m_count % granularity[consumer] == 0);
+        CHECK(lease.m_count > 0);
+        leases.push_back(lease);
+    }
+    for (std::size_t i = 0; i < leases.size(); i++)
+    {
+        for (std::size_t j = i + 1; j < leases.size(); j++)
+        {
+            bool const disjoint = leases[i].end() <= leases[j].m_first || leases[j].end() <= leases[i].m_first;
+            CHECK(disjoint);
+        }
+    }
+}
+
+void test_new_block_starts_over()
+{
+    Nonce_allocator allocator;
+    auto const consumer = allocator.add_consumer(1, 100, 0ms);
+    CHECK(allocator.lease(consumer).m_first == 0);
+    CHECK(allocator.lease(consumer).m_first == 100);
+    allocator.new_block();
+    CHECK(allocator.lease(consumer).m_first == 0);
+}
+
+void test_rate_sizing()
+{
+    Nonce_allocator allocator;
+    auto const consumer = allocator.add_consumer(10, 1000, 1s);
+    CHECK(allocator.get_rate(consumer) == 0.0);
+    CHECK(allocator.lease(consumer).m_count == 1000);
+    //1000 nonces in at least 10ms is at most 100000 per second.  The next lease lasts about 1s.
+    std::this_thread::sleep_for(10ms);
+    auto const lease = allocator.lease(consumer);
+    CHECK(allocator.get_rate(consumer) > 0.0);
+    CHECK(allocator.get_rate(consumer) <= 100000.0);
+    CHECK(lease.m_count > 1000);
+    CHECK(lease.m_count <= 100000);
+    CHECK(lease.m_count % 10 == 0);
+}
+
+void test_rate_sizing_capped()
+{
+    Nonce_allocator allocator;
+    //a huge first lease used up in a millisecond and a long lease duration ask for far more than the cap
+    auto const consumer = allocator.add_consumer(1, 1ULL << 40, 1000s);
+    allocator.lease(consumer);
+    std::this_thread::sleep_for(1ms);
+    CHECK(allocator.lease(consumer).m_count == 1ULL << 48);
+}
+
+void test_unmined_lease_not_measured()
+{
+    Nonce_allocator allocator;
+    auto const consumer = allocator.add_consumer(1, 1000, 1s);
+    allocator.lease(consumer);
+    std::this_thread::sleep_for(10ms);
+    auto const measured = allocator.lease(consumer).m_count;
+
+    //the consumer takes a lease between new_block() and picking up the block.  It never mines it.
+    allocator.new_block();
+    allocator.lease(consumer);
+    allocator.new_work(consumer);
+    //microseconds later.  Without new_work this would measure an absurd rate.
+    CHECK(allocator.lease(consumer).m_count == measured);
+}
+
+void test_removed_consumer_reused()
+{
+    Nonce_allocator allocator;
+    auto const first = allocator.add_consumer(1, 100, 0ms);
+    auto const second = allocator.add_consumer(1, 100, 0ms);
+    allocator.remove_consumer(first);
+    //a recreated worker takes the free id.  The settings are its own.
+    auto const third = allocator.add_consumer(7, 70, 0ms);
+    CHECK(third == first);
+    CHECK(allocator.lease(third).m_count == 70);
+    CHECK(allocator.add_consumer(1, 100, 0ms) == second + 1);
+}
+
+}
+}
+
+int main()
+{
+    nexusminer::test_leases_never_overlap();
+    nexusminer::test_new_block_starts_over();
+    nexusminer::test_rate_sizing();
+    nexusminer::test_rate_sizing_capped();
+    nexusminer::test_unmined_lease_not_measured();
+    nexusminer::test_removed_consumer_reused();
+    return nexusminer::test::result();
+}
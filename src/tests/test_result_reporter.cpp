@@ -0,0 +1,191 @@
+#include "check.hpp"
+#include "result_ring.hpp"
+#include "result_reporter.hpp"
+#include "work_slot.hpp"
+#include "worker.hpp"
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+namespace nexusminer {
+namespace {
+
+Result make_result(std::uint64_t generation, std::uint64_t nonce, std::uint32_t worker_id = 0)
+{
+    return Result{ worker_id, generation, nonce, 0.0 };
+}
+
+void test_ring_empty_and_full()
+{
+    Result_ring<4> ring;
+    std::size_t handled = 0;
+    CHECK(ring.drain([&handled](Result const&) { handled++; }) == 0);
+    CHECK(handled == 0);
+
+    for (std::uint64_t i = 0; i < 4; i++)
+    {
+        CHECK(ring.push(make_result(1, i)));
+    }
+    //full.  The result is dropped.
+    CHECK(!ring.push(make_result(1, 4)));
+
+    std::vector<std::uint64_t> nonces;
+    CHECK(ring.drain([&nonces](Result const& result) { nonces.push_back(result.m_nonce); }) == 4);
+    CHECK((nonces == std::vector<std::uint64_t>{ 0, 1, 2, 3 }));
+
+    //the slots are free again
+    CHECK(ring.push(make_result(1, 5)));
+    nonces.clear();
+    CHECK(ring.drain([&nonces](Result const& result) { nonces.push_back(result.m_nonce); }) == 1);
+    CHECK((nonces == std::vector<std::uint64_t>{ 5 }));
+}
+
+void test_ring_wraps_around_in_order()
+{
+    Result_ring<4> ring;
+    std::uint64_t next_pushed = 0;
+    std::uint64_t next_drained = 0;
+    bool in_order = true;
+    for (int cycle = 0; cycle < 100; cycle++)
+    {
+        //3 at a time so the positions move through every slot
+        for (int i = 0; i < 3; i++)
+        {
+            CHECK(ring.push(make_result(1, next_pushed++)));
+        }
+        ring.drain([&next_drained, &in_order](Result const& result) { in_order = in_order && result.m_nonce == next_drained++; });
+    }
+    CHECK(in_order);
+    CHECK(next_drained == next_pushed);
+}
+
+void test_ring_request_drain_once()
+{
+    Result_ring<4> ring;
+    CHECK(ring.request_drain());
+    //a drain is scheduled already
+    CHECK(!ring.request_drain());
+    ring.drain([](Result const&) {});
+    CHECK(ring.request_drain());
+}
+
+void test_ring_many_producers()
+{
+    constexpr std::uint32_t producers = 4;
+    constexpr std::uint64_t per_producer = 10000;
+    Result_ring<64> ring;
+    std::vector<std::thread> threads;
+    for (std::uint32_t p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&ring, p]()
+        {
+            for (std::uint64_t i = 0; i < per_producer; i++)
+            {
+                while (!ring.push(make_result(1, i, p)))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    //every producer's results come out in the order it pushed them
+    std::vector<std::uint64_t> next(producers, 0);
+    bool in_order = true;
+    std::uint64_t received = 0;
+    while (received < producers * per_producer)
+    {
+        received += ring.drain([&next, &in_order](Result const& result)
+        {
+            in_order = in_order && result.m_nonce == next[result.m_worker_id];
+            next[result.m_worker_id]++;
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    CHECK(in_order);
+    CHECK(received == producers * per_producer);
+}
+
+struct Work
+{
+    Block_data m_block;
+    Worker::Block_found_handler m_found_nonce_callback;
+};
+
+void test_reporter_drops_stale_results()
+{
+    Work_slot<Work> work_slot;
+    std::vector<std::uint64_t> found;
+    auto make_work = [&found]()
+    {
+        auto work = std::make_shared<Work>();
+        work->m_found_nonce_callback = [&found](std::uint32_t, std::unique_ptr<Block_data>&& block)
+        {
+            found.push_back(block->nNonce);
+        };
+        return work;
+    };
+    Result_reporter<Work, 8> reporter{ work_slot, spdlog::default_logger(), "test: ", "nonce" };
+    int drains_scheduled = 0;
+    auto schedule = [&drains_scheduled]() { drains_scheduled++; };
+
+    //no work yet
+    reporter.submit(make_result(0, 1), schedule);
+    CHECK(reporter.drain() == 0);
+    CHECK(found.empty());
+
+    work_slot.publish(make_work(), Work_slot<Work>::Clock::now());
+    std::uint64_t generation = 0;
+    work_slot.current(generation);
+    reporter.submit(make_result(generation, 10), schedule);
+    reporter.submit(make_result(generation - 1, 11), schedule);
+    reporter.submit(make_result(generation, 12), schedule);
+    //one drain for the three results
+    CHECK(drains_scheduled == 2);
+    CHECK(reporter.drain() == 2);
+    CHECK((found == std::vector<std::uint64_t>{ 10, 12 }));
+
+    //found for the old block, drained after the new one was published
+    reporter.submit(make_result(generation, 13), schedule);
+    work_slot.publish(make_work(), Work_slot<Work>::Clock::now());
+    CHECK(reporter.drain() == 0);
+    CHECK(found.size() == 2);
+}
+
+void test_reporter_full_ring_drops()
+{
+    Work_slot<Work> work_slot;
+    std::size_t found = 0;
+    auto work = std::make_shared<Work>();
+    work->m_found_nonce_callback = [&found](std::uint32_t, std::unique_ptr<Block_data>&&) { found++; };
+    work_slot.publish(work, Work_slot<Work>::Clock::now());
+    std::uint64_t generation = 0;
+    work_slot.current(generation);
+
+    Result_reporter<Work, 4> reporter{ work_slot, spdlog::default_logger(), "test: ", "nonce" };
+    for (std::uint64_t i = 0; i < 6; i++)
+    {
+        reporter.submit(make_result(generation, i), []() {});
+    }
+    CHECK(reporter.drain() == 4);
+    CHECK(found == 4);
+}
+
+}
+}
+
+int main()
+{
+    spdlog::set_level(spdlog::level::off);
+    nexusminer::test_ring_empty_and_full();
+    nexusminer::test_ring_wraps_around_in_order();
+    nexusminer::test_ring_request_drain_once();
+    nexusminer::test_ring_many_producers();
+    nexusminer::test_reporter_drops_stale_results();
+    nexusminer::test_reporter_full_ring_drops();
+    return nexusminer::test::result();
+}
@@ -0,0 +1,98 @@
+#include "check.hpp"
+#include "stats/rate_tracker.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace nexusminer {
+namespace {
+
+using namespace std::chrono_literals;
+using stats::Rate_tracker;
+
+bool near(double value, double expected)
+{
+    return std::abs(value - expected) <= 1e-9 * std::max(1.0, std::abs(expected));
+}
+
+void test_first_measurement()
+{
+    auto const start = Rate_tracker::Clock::now();
+    Rate_tracker tracker{ start };
+    //the averages start at the first rate instead of ramping up from 0
+    tracker.update(600, start + 10s);
+    CHECK(near(tracker.get_rates().m_1m, 60.0));
+    CHECK(near(tracker.get_rates().m_15m, 60.0));
+    CHECK(near(tracker.get_rates().m_lifetime, 60.0));
+}
+
+void test_exact_decay()
+{
+    auto const start = Rate_tracker::Clock::now();
+    Rate_tracker tracker{ start };
+    tracker.update(600, start + 10s);
+    //no progress for 60s.  The 1 minute average decays by exactly e^-1, independent of the update interval.
+    tracker.update(600, start + 70s);
+    CHECK(near(tracker.get_rates().m_1m, 60.0 * std::exp(-1.0)));
+    CHECK(near(tracker.get_rates().m_15m, 60.0 * std::exp(-60.0 / 900.0)));
+    CHECK(near(tracker.get_rates().m_lifetime, 600.0 / 70.0));
+
+    //the same 60s in three irregular steps decay the same
+    Rate_tracker stepped{ start };
+    stepped.update(600, start + 10s);
+    stepped.update(600, start + 15s);
+    stepped.update(600, start + 52s);
+    stepped.update(600, start + 70s);
+    CHECK(near(stepped.get_rates().m_1m, tracker.get_rates().m_1m));
+    CHECK(near(stepped.get_rates().m_15m, tracker.get_rates().m_15m));
+}
+
+void test_moves_towards_new_rate()
+{
+    auto const start = Rate_tracker::Clock::now();
+    Rate_tracker tracker{ start };
+    tracker.update(100, start + 10s);
+    //100 per second for 30s
+    tracker.update(3100, start + 40s);
+    double const weight = 1.0 - std::exp(-30.0 / 60.0);
+    CHECK(near(tracker.get_rates().m_1m, 10.0 + weight * (100.0 - 10.0)));
+}
+
+void test_counter_starts_over()
+{
+    auto const start = Rate_tracker::Clock::now();
+    Rate_tracker tracker{ start };
+    tracker.update(600, start + 10s);
+    //the worker was recreated and counts from 0.  100 in 10s, not a negative rate.
+    tracker.update(100, start + 20s);
+    double const weight = 1.0 - std::exp(-10.0 / 60.0);
+    CHECK(near(tracker.get_rates().m_1m, 60.0 + weight * (10.0 - 60.0)));
+    //the lifetime total keeps counting across the restart
+    CHECK(near(tracker.get_rates().m_lifetime, 700.0 / 20.0));
+}
+
+void test_same_time_ignored()
+{
+    auto const start = Rate_tracker::Clock::now();
+    Rate_tracker tracker{ start };
+    tracker.update(600, start + 10s);
+    tracker.update(900, start + 10s);
+    CHECK(near(tracker.get_rates().m_1m, 60.0));
+    //the count is taken with the next update
+    tracker.update(900, start + 20s);
+    double const weight = 1.0 - std::exp(-10.0 / 60.0);
+    CHECK(near(tracker.get_rates().m_1m, 60.0 + weight * (30.0 - 60.0)));
+}
+
+}
+}
+
+int main()
+{
+    nexusminer::test_first_measurement();
+    nexusminer::test_exact_decay();
+    nexusminer::test_moves_towards_new_rate();
+    nexusminer::test_counter_starts_over();
+    nexusminer::test_same_time_ignored();
+    return nexusminer::test::result();
+}
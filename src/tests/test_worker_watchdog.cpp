@@ -0,0 +1,128 @@
+#include "check.hpp"
+#include "worker_watchdog.hpp"
+#include <chrono>
+#include <cstdint>
+
+namespace nexusminer {
+namespace {
+
+using namespace std::chrono_literals;
+using Verdict = Worker_watchdog::Verdict;
+
+Worker_watchdog::Clock::time_point at(std::chrono::milliseconds time)
+{
+    return Worker_watchdog::Clock::time_point{} + time;
+}
+
+void test_reissue_then_recreate()
+{
+    //stalled after 3 times the check interval (the worker progresses faster than once per interval)
+    Worker_watchdog watchdog{ 1, 3.0, 1s };
+    CHECK(watchdog.check(0, 0, at(0s)) == Verdict::ok);
+    CHECK(watchdog.check(0, 10, at(1s)) == Verdict::ok);
+    CHECK(watchdog.check(0, 10, at(2s)) == Verdict::ok);
+    CHECK(watchdog.check(0, 10, at(3999ms)) == Verdict::ok);
+    CHECK(watchdog.check(0, 10, at(4s)) == Verdict::reissue);
+    //the next verdict comes one stall period later
+    CHECK(watchdog.check(0, 10, at(5s)) == Verdict::ok);
+    CHECK(watchdog.check(0, 10, at(6999ms)) == Verdict::ok);
+    CHECK(watchdog.check(0, 10, at(7s)) == Verdict::recreate);
+
+    //the replacement starts over from 0
+    watchdog.reset(0, at(7s));
+    CHECK(watchdog.check(0, 0, at(8s)) == Verdict::ok);
+    CHECK(watchdog.check(0, 5, at(9s)) == Verdict::ok);
+    CHECK(watchdog.check(0, 5, at(12s)) == Verdict::reissue);
+}
+
+void test_progress_after_reissue()
+{
+    Worker_watchdog watchdog{ 1, 3.0, 1s };
+    watchdog.check(0, 0, at(0s));
+    watchdog.check(0, 10, at(1s));
+    CHECK(watchdog.check(0, 10, at(4s)) == Verdict::reissue);
+    //the reissue helped
+    CHECK(watchdog.check(0, 20, at(5s)) == Verdict::ok);
+    //a later stall starts with a reissue again
+    CHECK(watchdog.check(0, 20, at(8s)) == Verdict::reissue);
+    CHECK(watchdog.check(0, 20, at(11s)) == Verdict::recreate);
+}
+
+void test_slow_worker()
+{
+    //one unit of progress every 10s.  Stalled after 30s without progress.
+    Worker_watchdog watchdog{ 1, 3.0, 1s };
+    watchdog.check(0, 0, at(0s));
+    CHECK(watchdog.check(0, 1, at(10s)) == Verdict::ok);
+    CHECK(watchdog.check(0, 1, at(39s)) == Verdict::ok);
+    CHECK(watchdog.check(0, 1, at(40s)) == Verdict::reissue);
+}
+
+void test_no_progress_yet()
+{
+    //nothing to compare with until the worker made progress once
+    Worker_watchdog watchdog{ 2, 3.0, 1s };
+    watchdog.check(0, 0, at(0s));
+    CHECK(watchdog.check(0, 0, at(100s)) == Verdict::ok);
+    //the other worker is judged on its own
+    watchdog.check(1, 0, at(0s));
+    watchdog.check(1, 1, at(1s));
+    CHECK(watchdog.check(1, 1, at(100s)) == Verdict::reissue);
+    CHECK(watchdog.check(0, 0, at(200s)) == Verdict::ok);
+}
+
+void test_counter_reset()
+{
+    //the progress counter going down (statistics reset) is a new start, not a stall
+    Worker_watchdog watchdog{ 1, 3.0, 1s };
+    watchdog.check(0, 0, at(0s));
+    watchdog.check(0, 100, at(1s));
+    CHECK(watchdog.check(0, 5, at(10s)) == Verdict::ok);
+    CHECK(watchdog.check(0, 5, at(12999ms)) == Verdict::ok);
+    CHECK(watchdog.check(0, 5, at(13s)) == Verdict::reissue);
+}
+
+void test_burst_keeps_estimate()
+{
+    //a sparse counter: one unit every 10s, then one 1s after the last
+    Worker_watchdog watchdog{ 1, 5.0, 1s };
+    watchdog.check(0, 0, at(0s));
+    for (std::uint64_t i = 1; i <= 10; i++)
+    {
+        watchdog.check(0, i, at(i * 10s));
+    }
+    watchdog.check(0, 11, at(101s));
+    //about 9.2s per unit over the whole history, not the average of the last two gaps
+    CHECK(watchdog.check(0, 11, at(140s)) == Verdict::ok);
+    CHECK(watchdog.check(0, 11, at(150s)) == Verdict::reissue);
+}
+
+void test_idle_is_no_stall()
+{
+    Worker_watchdog watchdog{ 1, 3.0, 1s };
+    watchdog.check(0, 0, at(0s));
+    watchdog.check(0, 10, at(1s));
+    //found its nonce and waits for the next block.  The worker manager reports it idle instead of checking it.
+    watchdog.idle(0, 10, at(2s));
+    watchdog.idle(0, 10, at(100s));
+    CHECK(watchdog.check(0, 10, at(102s)) == Verdict::ok);
+    //mining again.  The idle time didn't change the usual time between progress.
+    CHECK(watchdog.check(0, 20, at(103s)) == Verdict::ok);
+    CHECK(watchdog.check(0, 20, at(105999ms)) == Verdict::ok);
+    CHECK(watchdog.check(0, 20, at(106s)) == Verdict::reissue);
+}
+
+}
+}
+
+int main()
+{
+    nexusminer::test_reissue_then_recreate();
+    nexusminer::test_progress_after_reissue();
+    nexusminer::test_slow_worker();
+    nexusminer::test_no_progress_yet();
+    nexusminer::test_counter_reset();
+    nexusminer::test_burst_keeps_estimate();
+    nexusminer::test_idle_is_no_stall();
+    return nexusminer::test::result();
+}
@@ -17,6 +17,7 @@ Timer_manager::Timer_manager(chrono::Timer_factory::Sptr timer_factory)
     m_ping_timer = m_timer_factory->create_timer();
     m_stats_collector_timer = m_timer_factory->create_timer();
     m_stats_printer_timer = m_timer_factory->create_timer();
+    m_watchdog_timer = m_timer_factory->create_timer();
 }
 
 void Timer_manager::start_connection_retry_timer(std::uint16_t timer_interval, std::weak_ptr<Worker_manager> worker_manager, 
@@ -48,6 +49,11 @@ void Timer_manager::start_stats_printer_timer(std::uint16_t timer_interval, std:
     m_stats_printer_timer->start(chrono::Seconds(timer_interval), stats_printer_handler(timer_interval, std::move(stats_printers)));
 }
 
+void Timer_manager::start_watchdog_timer(std::uint16_t timer_interval, std::weak_ptr<Worker_manager> worker_manager)
+{
+    m_watchdog_timer->start(chrono::Seconds(timer_interval), watchdog_handler(timer_interval, std::move(worker_manager)));
+}
+
 void Timer_manager::stop()
 {
     m_connection_retry_timer->cancel();
@@ -55,6 +61,7 @@ void Timer_manager::stop()
     m_ping_timer->cancel();
     m_stats_collector_timer->cancel();
     m_stats_printer_timer->cancel();
+    m_watchdog_timer->cancel();
 }
 
 chrono::Timer::Handler Timer_manager::connection_retry_handler(std::weak_ptr<Worker_manager> worker_manager,
@@ -159,4 +166,24 @@ chrono::Timer::Handler Timer_manager::stats_printer_handler(std::uint16_t stats_
     }; 
 }
 
-}
\ No newline at end of file
+chrono::Timer::Handler Timer_manager::watchdog_handler(std::uint16_t watchdog_interval, std::weak_ptr<Worker_manager> worker_manager)
+{
+    return[this, watchdog_interval, worker_manager](bool canceled)
+    {
+        if (canceled)	// don't do anything if the timer has been canceled
+        {
+            return;
+        }
+
+        auto worker_manager_shared = worker_manager.lock();
+        if (worker_manager_shared)
+        {
+            worker_manager_shared->check_workers();
+
+            // restart timer
+            m_watchdog_timer->start(chrono::Seconds(watchdog_interval), watchdog_handler(watchdog_interval, std::move(worker_manager)));
+        }
+    };
+}
+
+}
@@ -36,6 +36,7 @@ public:
     void start_stats_collector_timer(std::uint16_t timer_interval, std::vector<std::shared_ptr<Worker>> workers, 
         std::shared_ptr<stats::Collector> stats_collector);
     void start_stats_printer_timer(std::uint16_t timer_interval, std::vector<std::shared_ptr<stats::Printer>> stats_printers);
+    void start_watchdog_timer(std::uint16_t timer_interval, std::weak_ptr<Worker_manager> worker_manager);
 
     void stop();
 
@@ -48,6 +49,7 @@ private:
     chrono::Timer::Handler stats_collector_handler(std::uint16_t stats_collector_interval, std::vector<std::shared_ptr<Worker>> workers, 
         std::shared_ptr<stats::Collector> stats_collector);
     chrono::Timer::Handler stats_printer_handler(std::uint16_t stats_printer_interval, std::vector<std::shared_ptr<stats::Printer>> stats_printers);
+    chrono::Timer::Handler watchdog_handler(std::uint16_t watchdog_interval, std::weak_ptr<Worker_manager> worker_manager);
 
     chrono::Timer_factory::Sptr m_timer_factory;
     chrono::Timer::Uptr m_connection_retry_timer;
@@ -55,6 +57,7 @@ private:
     chrono::Timer::Uptr m_ping_timer;
     chrono::Timer::Uptr m_stats_collector_timer;
     chrono::Timer::Uptr m_stats_printer_timer;
+    chrono::Timer::Uptr m_watchdog_timer;
 };
 }
 
@@ -0,0 +1,59 @@
+#ifndef NEXUSMINER_LATENCY_SAMPLES_HPP
+#define NEXUSMINER_LATENCY_SAMPLES_HPP
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace nexusminer {
+
+// The latest block switch latencies of a worker (time from receiving a block until mining it) and their percentiles.
+// Not thread safe.  The owner serialises access.
+class Latency_samples
+{
+public:
+
+    void add(std::chrono::microseconds latency)
+    {
+        auto const latency_us = static_cast<std::uint32_t>(std::min<std::chrono::microseconds::rep>(latency.count(), UINT32_MAX));
+        m_samples[m_count % sample_count] = latency_us;
+        m_count++;
+        m_max = std::max(m_max, latency_us);
+    }
+
+    // p in [0, 1].  0 if there are no samples.
+    std::chrono::microseconds percentile(double p) const
+    {
+        auto const count = std::min(m_count, sample_count);
+        if (count == 0)
+        {
+            return std::chrono::microseconds{0};
+        }
+        auto samples = m_samples;
+        auto const nth = samples.begin() + std::min(count - 1, static_cast<std::size_t>(p * count));
+        std::nth_element(samples.begin(), nth, samples.begin() + count);
+        return std::chrono::microseconds{*nth};
+    }
+
+    std::chrono::microseconds max() const { return std::chrono::microseconds{m_max}; }
+
+    void reset()
+    {
+        m_count = 0;
+        m_max = 0;
+    }
+
+private:
+
+    //one sample per block.  A few hours of blocks.
+    static constexpr std::size_t sample_count = 256;
+    std::array<std::uint32_t, sample_count> m_samples{};
+    std::size_t m_count{0};
+    std::uint32_t m_max{0};
+};
+
+}
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef NEXUSMINER_NONCE_ALLOCATOR_HPP
+#define NEXUSMINER_NONCE_ALLOCATOR_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace nexusminer {
+
+// Hands out ranges of the nonce space (or prime sieve offsets) to the mining threads and devices of all workers.
+// Owned by Worker_manager.  Ranges never overlap within a block.  new_block() starts over for the next block.
+// Each consumer gets leases sized to last about its lease duration at the rate it used up its previous lease,
+// so fast devices take more of the space than slow ones.
+// A lease starts at a multiple of the granularity of its consumer.  A consumer that moves its start up by less than the
+// granularity (the prime sieve start is rounded to a multiple of 30) moves every lease by the same amount so they still don't overlap.
+class Nonce_allocator
+{
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    // the nonces [m_first, m_first + m_count)
+    struct Lease
+    {
+        std::uint64_t m_first{0};
+        std::uint64_t m_count{0};
+
+        std::uint64_t end() const { return m_first + m_count; }
+    };
+
+    Nonce_allocator()
+    : m_next{0}
+    , m_block{0}
+    {
+    }
+
+    // register a mining thread or device.  Every lease is a multiple of granularity (a kernel call, a sieve segment) long
+    // and starts at a multiple of it.
+    // initial_count is the size of the first lease, before the rate of the consumer is known.
+    // The id of a removed consumer is reused.
+    std::size_t add_consumer(std::uint64_t granularity, std::uint64_t initial_count, std::chrono::milliseconds lease_duration)
+    {
+        std::scoped_lock<std::mutex> lck(m_mtx);
+        Consumer consumer;
+        consumer.m_granularity = std::max<std::uint64_t>(granularity, 1);
+        consumer.m_lease_duration = lease_duration;
+        consumer.m_next_count = round_up(initial_count, consumer.m_granularity);
+        auto const free_consumer = std::find_if(m_consumers.begin(), m_consumers.end(), [](Consumer const& c) { return !c.m_active; });
+        if (free_consumer != m_consumers.end())
+        {
+            *free_consumer = consumer;
+            return static_cast<std::size_t>(free_consumer - m_consumers.begin());
+        }
+        m_consumers.push_back(consumer);
+        return m_consumers.size() - 1;
+    }
+
+    // the worker of the consumer is destroyed
+    void remove_consumer(std::size_t consumer_id)
+    {
+        std::scoped_lock<std::mutex> lck(m_mtx);
+        m_consumers[consumer_id].m_active = false;
+    }
+
+    // the leases of the previous block are void.  Called before the workers get the new block.
+    void new_block()
+    {
+        std::scoped_lock<std::mutex> lck(m_mtx);
+        m_next = 0;
+        m_block++;
+    }
+
+    // the consumer picked up new work.  Its current lease may be from a block it never mined (taken between new_block()
+    // and the workers getting the block) so it is not used to measure the rate.
+    void new_work(std::size_t consumer_id)
+    {
+        std::scoped_lock<std::mutex> lck(m_mtx);
+        m_consumers[consumer_id].m_leased_count = 0;
+    }
+
+    // the next range for the consumer.  Called when the previous lease is used up.
+    Lease lease(std::size_t consumer_id)
+    {
+        std::scoped_lock<std::mutex> lck(m_mtx);
+        auto& consumer = m_consumers[consumer_id];
+        auto const now = Clock::now();
+        if (consumer.m_block == m_block && consumer.m_leased_count != 0)
+        {
+            //the previous lease of this block is used up.  Its duration gives the rate of the consumer.
+            auto const elapsed = std::chrono::duration<double>(now - consumer.m_leased).count();
+            if (elapsed > 0.0)
+            {
+                double const rate = consumer.m_leased_count / elapsed;
+                consumer.m_rate = consumer.m_rate == 0.0 ? rate : (consumer.m_rate + rate) / 2;
+                auto const count = consumer.m_rate * std::chrono::duration<double>(consumer.m_lease_duration).count();
+                consumer.m_next_count = round_up(static_cast<std::uint64_t>(std::min(count, static_cast<double>(max_lease_count))),
+                    consumer.m_granularity);
+            }
+        }
+        return take(consumer, consumer.m_next_count, now);
+    }
+
+    // a range of a fixed size.  For devices that can't come back for more during a block.
+    Lease lease(std::size_t consumer_id, std::uint64_t count)
+    {
+        std::scoped_lock<std::mutex> lck(m_mtx);
+        auto& consumer = m_consumers[consumer_id];
+        return take(consumer, round_up(count, consumer.m_granularity), Clock::now());
+    }
+
+    // measured throughput of the consumer in nonces per second.  0 until it has used up a lease.
+    double get_rate(std::size_t consumer_id) const
+    {
+        std::scoped_lock<std::mutex> lck(m_mtx);
+        return m_consumers[consumer_id].m_rate;
+    }
+
+private:
+
+    //upper limit of a single lease so one consumer can't claim the whole space with a bad measurement
+    static constexpr std::uint64_t max_lease_count = 1ULL << 48;
+
+    struct Consumer
+    {
+        bool m_active{true};
+        std::uint64_t m_granularity{1};
+        std::chrono::milliseconds m_lease_duration{0};
+        std::uint64_t m_next_count{0};
+        double m_rate{0.0};
+        //the current lease
+        std::uint64_t m_block{0};
+        std::uint64_t m_leased_count{0};
+        Clock::time_point m_leased{};
+    };
+
+    static std::uint64_t round_up(std::uint64_t count, std::uint64_t granularity)
+    {
+        return std::max<std::uint64_t>(1, (count + granularity - 1) / granularity) * granularity;
+    }
+
+    Lease take(Consumer& consumer, std::uint64_t count, Clock::time_point now)
+    {
+        Lease lease{ (m_next + consumer.m_granularity - 1) / consumer.m_granularity * consumer.m_granularity, count };
+        m_next = lease.end();
+        consumer.m_block = m_block;
+        consumer.m_leased_count = count;
+        consumer.m_leased = now;
+        return lease;
+    }
+
+    mutable std::mutex m_mtx;
+    std::uint64_t m_next;
+    std::uint64_t m_block;
+    std::vector<Consumer> m_consumers;
+};
+
+}
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef NEXUSMINER_RESULT_REPORTER_HPP
+#define NEXUSMINER_RESULT_REPORTER_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include "worker.hpp"
+#include "work_slot.hpp"
+#include "result_ring.hpp"
+#include <spdlog/spdlog.h>
+
+namespace nexusminer {
+
+// Hands the results of the mining threads to the io thread.  The mining threads submit() to a Result_ring,
+// the io thread drain()s it and calls the found callback of the current work for the results that still belong to it.
+// Work needs m_block and m_found_nonce_callback.
+template<typename Work, std::size_t Capacity>
+class Result_reporter
+{
+public:
+
+    // result_name is used in the log ("nonce", "chain")
+    Result_reporter(Work_slot<Work> const& work, std::shared_ptr<spdlog::logger> logger, std::string log_leader, std::string result_name)
+    : m_work{work}
+    , m_logger{std::move(logger)}
+    , m_log_leader{std::move(log_leader)}
+    , m_result_name{std::move(result_name)}
+    {
+    }
+
+    // mining threads.  Never blocks.  schedule_drain is called when drain() has to be run once on the io thread.
+    template<typename Schedule>
+    void submit(Result const& result, Schedule&& schedule_drain)
+    {
+        if (!m_results.push(result))
+        {
+            m_logger->warn(m_log_leader + "Result queue full. Dropping {} {}.", m_result_name, result.m_nonce);
+            return;
+        }
+        if (m_results.request_drain())
+        {
+            schedule_drain();
+        }
+    }
+
+    // io thread.  Returns the number of results passed to the found callback.
+    std::size_t drain()
+    {
+        std::uint64_t generation = 0;
+        auto const work = m_work.current(generation);
+        std::size_t submitted = 0;
+        m_results.drain([this, &work, generation, &submitted](Result const& result)
+        {
+            //found for a block that has been replaced since.  The pool or wallet would reject it.
+            if (!work || result.m_generation != generation)
+            {
+                m_logger->debug(m_log_leader + "Dropping {} {} of an old block.", m_result_name, result.m_nonce);
+                return;
+            }
+            if (!work->m_found_nonce_callback)
+            {
+                m_logger->debug(m_log_leader + "Miner callback function not set.");
+                return;
+            }
+            //update the block with the nonce and call the callback function
+            auto block_data = std::make_unique<Block_data>(work->m_block);
+            block_data->nNonce = result.m_nonce;
+            work->m_found_nonce_callback(result.m_worker_id, std::move(block_data));
+            submitted++;
+        });
+        return submitted;
+    }
+
+private:
+
+    Work_slot<Work> const& m_work;
+    std::shared_ptr<spdlog::logger> m_logger;
+    std::string m_log_leader;
+    std::string m_result_name;
+    Result_ring<Capacity> m_results;
+};
+
+}
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef NEXUSMINER_RESULT_RING_HPP
+#define NEXUSMINER_RESULT_RING_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace nexusminer {
+
+// A nonce or chain found by a mining thread.  Fixed size so reporting it never allocates.
+struct Result
+{
+    std::uint32_t m_worker_id;
+    // Work_slot generation of the work the result was found for.  Results of replaced work are dropped.
+    std::uint64_t m_generation;
+    std::uint64_t m_nonce;
+    // leading zeros (hash) or chain difficulty (prime)
+    double m_difficulty;
+};
+
+// Bounded lock free queue of results from the mining threads (many producers) to the io thread (one consumer).
+// push() never blocks or allocates.  When the ring is full the result is dropped and push() returns false.
+// The producer that makes request_drain() return true has to schedule one drain() on the io thread.
+template<std::size_t Capacity>
+class Result_ring
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+
+    Result_ring()
+    : m_head{0}
+    , m_tail{0}
+    , m_drain_pending{false}
+    {
+        for (std::size_t i = 0; i < Capacity; i++)
+        {
+            m_slots[i].m_sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(Result const& result)
+    {
+        std::size_t position = m_tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            auto& slot = m_slots[position & (Capacity - 1)];
+            std::size_t const sequence = slot.m_sequence.load(std::memory_order_acquire);
+            auto const diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+            if (diff == 0)
+            {
+                //the slot is free.  Claim it.
+                if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    slot.m_result = result;
+                    slot.m_sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                //the consumer has not read the slot yet
+                return false;
+            }
+            else
+            {
+                position = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // true if no drain is scheduled yet.  The caller has to schedule one.
+    bool request_drain()
+    {
+        return !m_drain_pending.exchange(true, std::memory_order_acq_rel);
+    }
+
+    // consumer only.  Calls handler for every result in the ring and returns the number of results.
+    template<typename Handler>
+    std::size_t drain(Handler&& handler)
+    {
+        //cleared first so a result pushed during the drain schedules the next one.
+        //an exchange so the results pushed before the last request_drain are visible here.
+        m_drain_pending.exchange(false, std::memory_order_acq_rel);
+        std::size_t count = 0;
+        for (;;)
+        {
+            auto& slot = m_slots[m_head & (Capacity - 1)];
+            if (slot.m_sequence.load(std::memory_order_acquire) != m_head + 1)
+            {
+                return count;
+            }
+            Result const result = slot.m_result;
+            slot.m_sequence.store(m_head + Capacity, std::memory_order_release);
+            m_head++;
+            handler(result);
+            count++;
+        }
+    }
+
+private:
+
+    struct alignas(64) Slot
+    {
+        std::atomic<std::size_t> m_sequence;
+        Result m_result;
+    };
+
+    std::array<Slot, Capacity> m_slots;
+    // consumer position.  Only the io thread touches it.
+    alignas(64) std::size_t m_head;
+    alignas(64) std::atomic<std::size_t> m_tail;
+    std::atomic<bool> m_drain_pending;
+};
+
+}
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef NEXUSMINER_WORK_SLOT_HPP
+#define NEXUSMINER_WORK_SLOT_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include "latency_samples.hpp"
+
+namespace nexusminer {
+
+// Hands work from set_block (io thread) to long lived mining threads.
+// publish() stores the new work, bumps the generation and returns without waiting for the miners.
+// Mining threads poll changed() at safe points (once per batch or segment) and call wait() to pick up the new work.
+// The block switch latency is the time from receiving the block until the last consumer started mining it (mark_started()),
+// so it includes the per block setup of the miners (midstate, sieve starting multiples).
+template<typename Work>
+class Work_slot
+{
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    Work_slot()
+    : m_generation{0}
+    , m_stop{false}
+    , m_consumers{1}
+    , m_picked_up{0}
+    , m_waiting{0}
+    {
+    }
+
+    // number of threads that call wait() and mark_started().  Set before they start.
+    void set_consumers(unsigned consumers) { m_consumers = consumers; }
+
+    // received is when the block arrived from the wallet or pool
+    void publish(std::shared_ptr<Work const> work, Clock::time_point received)
+    {
+        {
+            std::scoped_lock<std::mutex> lck(m_mtx);
+            m_work = std::move(work);
+            m_received = received;
+            m_picked_up = 0;
+            m_generation.store(m_generation.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+        m_cv.notify_all();
+    }
+
+    // wakes up all waiting threads.  wait() returns nullptr from now on.
+    void stop()
+    {
+        {
+            std::scoped_lock<std::mutex> lck(m_mtx);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+    }
+
+    bool stopped() const { return m_stop.load(std::memory_order_relaxed); }
+
+    // cheap check for the hot loop.  True if there is newer work than generation or the slot was stopped.
+    bool changed(std::uint64_t generation) const
+    {
+        return m_generation.load(std::memory_order_relaxed) != generation || m_stop.load(std::memory_order_relaxed);
+    }
+
+    // blocks until there is work newer than generation.  generation is updated to the returned work.
+    // returns nullptr when the slot is stopped.
+    std::shared_ptr<Work const> wait(std::uint64_t& generation)
+    {
+        std::unique_lock<std::mutex> lck(m_mtx);
+        m_waiting++;
+        m_cv.wait(lck, [this, generation]()
+        {
+            return m_stop.load(std::memory_order_relaxed) || m_generation.load(std::memory_order_relaxed) != generation;
+        });
+        m_waiting--;
+        if (m_stop)
+        {
+            return nullptr;
+        }
+        generation = m_generation.load(std::memory_order_relaxed);
+        return m_work;
+    }
+
+    // true while every consumer waits for newer work than it has.  The worker pauses until the next block on purpose.
+    bool idle() const
+    {
+        std::scoped_lock<std::mutex> lck(m_mtx);
+        return m_waiting == m_consumers;
+    }
+
+    // a consumer finished the setup for the work of generation and starts mining it.
+    // Ignored if newer work has been published in the meantime.
+    void mark_started(std::uint64_t generation)
+    {
+        auto const now = Clock::now();
+        std::scoped_lock<std::mutex> lck(m_mtx);
+        if (generation != m_generation.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        //the last consumer to start completes the block switch
+        if (++m_picked_up == m_consumers)
+        {
+            m_switch_latency.add(std::chrono::duration_cast<std::chrono::microseconds>(now - m_received));
+        }
+    }
+
+    // the latest published work and its generation.  Used by the io thread to match results with the work they were found for.
+    std::shared_ptr<Work const> current(std::uint64_t& generation) const
+    {
+        std::scoped_lock<std::mutex> lck(m_mtx);
+        generation = m_generation.load(std::memory_order_relaxed);
+        return m_work;
+    }
+
+    // copy of the block switch latencies
+    Latency_samples get_switch_latency() const
+    {
+        std::scoped_lock<std::mutex> lck(m_mtx);
+        return m_switch_latency;
+    }
+    void reset_switch_latency()
+    {
+        std::scoped_lock<std::mutex> lck(m_mtx);
+        m_switch_latency.reset();
+    }
+
+private:
+
+    mutable std::mutex m_mtx;
+    std::condition_variable m_cv;
+    std::shared_ptr<Work const> m_work;
+    Clock::time_point m_received;
+    std::atomic<std::uint64_t> m_generation;
+    std::atomic<bool> m_stop;
+    unsigned m_consumers;
+    unsigned m_picked_up;
+    //consumers blocked in wait()
+    unsigned m_waiting;
+    Latency_samples m_switch_latency;
+};
+
+}
+
+#endif
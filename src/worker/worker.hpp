@@ -3,6 +3,8 @@
 
 #include <memory>
 #include <functional>
+#include <array>
+#include <chrono>
 #include "LLC/types/uint1024.h"
 #include "block.hpp"
 #include "hash/byte_utils.hpp"
@@ -25,35 +27,47 @@ public:
 
 	Block_data() {}
 
-	std::vector<unsigned char> GetHeaderBytes(bool excludeNonce = false)
+	//version, previous hash, merkle root, channel, height, bits and nonce.  Every field is little endian.
+	static constexpr std::size_t header_length = 216;
+	//the prime block hash excludes the nonce
+	static constexpr std::size_t header_length_prime = 208;
+	using Header_bytes = std::array<unsigned char, header_length>;
+
+	//Writes the header straight from the fields without allocating.  Returns the number of bytes written.
+	std::size_t WriteHeaderBytes(Header_bytes& header, bool excludeNonce = false) const
 	{
-		//convert header data to byte strings
-		std::vector<unsigned char> blockHeightB = IntToBytes(nHeight, 4);
-		std::vector<unsigned char> versionB = IntToBytes(nVersion, 4);
-		std::vector<unsigned char> channelB = IntToBytes(nChannel, 4);
-		std::vector<unsigned char> bitsB = IntToBytes(nBits, 4);
-		std::vector<unsigned char> nonceB = IntToBytes(nNonce, 8);
-		std::string merkleStr = merkle_root.GetHex();
-		std::string hashPrevBlockStr = previous_hash.GetHex();
-		std::vector<unsigned char> merkleB = HexStringToBytes(merkleStr);
-		std::vector<unsigned char> prevHashB = HexStringToBytes(hashPrevBlockStr);
-		std::reverse(merkleB.begin(), merkleB.end());
-		std::reverse(prevHashB.begin(), prevHashB.end());
-
-		//Concatenate the bytes
-		std::vector<unsigned char> headerB = versionB;
-		headerB.insert(headerB.end(), prevHashB.begin(), prevHashB.end());
-		headerB.insert(headerB.end(), merkleB.begin(), merkleB.end());
-		headerB.insert(headerB.end(), channelB.begin(), channelB.end());
-		headerB.insert(headerB.end(), blockHeightB.begin(), blockHeightB.end());
-		headerB.insert(headerB.end(), bitsB.begin(), bitsB.end());
+		std::size_t offset = 0;
+		auto write = [&header, &offset](uint64_t x, int len)
+		{
+			for (int i = 0; i < len; i++)
+			{
+				header[offset++] = static_cast<unsigned char>(x >> (8 * i));
+			}
+		};
+		write(nVersion, 4);
+		for (uint32_t i = 0; i < 1024 / 64; i++)
+		{
+			write(previous_hash.Get64(i), 8);
+		}
+		for (uint32_t i = 0; i < 512 / 64; i++)
+		{
+			write(merkle_root.Get64(i), 8);
+		}
+		write(nChannel, 4);
+		write(nHeight, 4);
+		write(nBits, 4);
 		if (!excludeNonce)
 		{
-			headerB.insert(headerB.end(), nonceB.begin(), nonceB.end());
+			write(nNonce, 8);
 		}
+		return offset;
+	}
 
-		return headerB;
-
+	std::vector<unsigned char> GetHeaderBytes(bool excludeNonce = false) const
+	{
+		Header_bytes header;
+		auto const length = WriteHeaderBytes(header, excludeNonce);
+		return std::vector<unsigned char>(header.begin(), header.begin() + length);
 	}
 	//The order of the block header data below matters for the cuda miner.  Be careful.
 	uint32_t nVersion = 4;
@@ -74,11 +88,23 @@ public:
     // A call to the BlockFoundHandler informs the user about a new found block.
     using Block_found_handler = std::function<void(std::uint32_t id, std::unique_ptr<Block_data>&& block)>;
 
+    using Clock = std::chrono::steady_clock;
+
     // Sets a new block (nexus data type) for the miner worker. The miner worker must reset the current work.
     // When  the worker finds a new block, the BlockFoundHandler has to be called with the found BlockData
-    virtual void set_block(LLP::CBlock block, std::uint32_t nbits, Block_found_handler result) = 0;
+    // received is when the block arrived from the wallet or pool.  The block switch latency of the worker is measured from there.
+    // Must not block. The worker manager hands the block to every worker in turn and each worker switches on its own threads.
+    virtual void set_block(LLP::CBlock block, std::uint32_t nbits, Block_found_handler result, Clock::time_point received) = 0;
 
     virtual void update_statistics(stats::Collector& stats_collector) = 0;
+
+    // True while the worker waits for the next block on purpose (the gpu hash worker after it found a nonce).
+    // The watchdog doesn't count that time as a stall.
+    virtual bool idle() const { return false; }
+
+    // Stops mining and cancels the i/o of the worker.  Must not block, the mining threads exit on their own.
+    // The device is released when the worker is destroyed.  Called before the worker manager replaces the worker.
+    virtual void stop() = 0;
 };
 
 }
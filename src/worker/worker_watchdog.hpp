@@ -0,0 +1,128 @@
+#ifndef NEXUSMINER_WORKER_WATCHDOG_HPP
+#define NEXUSMINER_WORKER_WATCHDOG_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace nexusminer {
+
+// Decides from the progress counters of the workers (hashes, candidates, integers searched) if a worker has stalled.
+// A worker is judged once it made progress at least once.  It is stalled when it made no progress for stall_factor times
+// the time it usually takes between two increments of its counter (never less than the check interval).
+// The usual time is the decayed sum of the time over the decayed sum of the progress, so a sparse counter that moves in
+// bursts (fpga nonce candidates) isn't judged by its last gap alone.
+// The first stall asks for the work to be reissued.  A worker still stalled one stall period later has to be recreated.
+// Only called from the io thread.
+class Worker_watchdog
+{
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    enum class Verdict
+    {
+        ok,
+        reissue,
+        recreate
+    };
+
+    Worker_watchdog(std::size_t worker_count, double stall_factor, std::chrono::seconds check_interval)
+    : m_workers(worker_count)
+    , m_stall_factor{std::max(stall_factor, 1.0)}
+    , m_check_interval{check_interval}
+    {
+    }
+
+    Verdict check(std::size_t worker, std::uint64_t progress, Clock::time_point now)
+    {
+        auto& state = m_workers[worker];
+        if (!state.m_started || progress < state.m_progress)
+        {
+            //first check or the counter was reset (worker recreated)
+            start(state, progress, now);
+            return Verdict::ok;
+        }
+        if (progress > state.m_progress)
+        {
+            //older time and progress count less, by e^-1 per estimate_horizon
+            double const seconds = std::chrono::duration<double>(now - state.m_last_progress).count();
+            double const decay = std::exp(-seconds / estimate_horizon.count());
+            state.m_seconds = state.m_seconds * decay + seconds;
+            state.m_units = state.m_units * decay + static_cast<double>(progress - state.m_progress);
+            state.m_progress = progress;
+            state.m_last_progress = now;
+            state.m_reissued = false;
+            return Verdict::ok;
+        }
+        if (state.m_units == 0.0)
+        {
+            //no progress yet.  Nothing to compare with.
+            return Verdict::ok;
+        }
+        double const seconds_per_unit = state.m_seconds / state.m_units;
+        auto const stall_period = std::chrono::duration<double>(
+            m_stall_factor * std::max(seconds_per_unit, std::chrono::duration<double>(m_check_interval).count()));
+        if (now - state.m_last_progress < stall_period)
+        {
+            return Verdict::ok;
+        }
+        //the next verdict comes one stall period later at the earliest
+        state.m_last_progress = now;
+        if (!state.m_reissued)
+        {
+            state.m_reissued = true;
+            return Verdict::reissue;
+        }
+        state.m_reissued = false;
+        return Verdict::recreate;
+    }
+
+    // the worker waits for the next block on purpose (found its nonce).  The time until then is neither a stall nor part of
+    // the usual time between progress.
+    void idle(std::size_t worker, std::uint64_t progress, Clock::time_point now)
+    {
+        start(m_workers[worker], progress, now);
+    }
+
+    // the worker was replaced.  Its counters start over.
+    void reset(std::size_t worker, Clock::time_point now)
+    {
+        auto& state = m_workers[worker];
+        start(state, 0, now);
+    }
+
+private:
+
+    static constexpr std::chrono::duration<double> estimate_horizon{900.0};
+
+    struct State
+    {
+        bool m_started{false};
+        std::uint64_t m_progress{0};
+        Clock::time_point m_last_progress{};
+        //decayed sums of the seconds and the progress they took
+        double m_seconds{0.0};
+        double m_units{0.0};
+        bool m_reissued{false};
+    };
+
+    static void start(State& state, std::uint64_t progress, Clock::time_point now)
+    {
+        state.m_started = true;
+        state.m_progress = progress;
+        state.m_last_progress = now;
+        state.m_reissued = false;
+    }
+
+    std::vector<State> m_workers;
+    double m_stall_factor;
+    std::chrono::seconds m_check_interval;
+};
+
+}
+
+#endif
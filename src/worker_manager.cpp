@@ -21,18 +21,73 @@
 #include "protocol/solo.hpp"
 #include "protocol/pool.hpp"
 #include "protocol/pool_legacy.hpp"
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <utility>
 #include <variant>
 
 namespace nexusminer
 {
+namespace
+{
+// seconds the destructor of a stalled worker gets to join its threads and release the device
+constexpr std::uint16_t teardown_timeout = 30;
+
+// Deletes a worker where its last reference is released.  Once the watchdog set torn_down the delete runs on its own thread,
+// the destructor joins the mining threads and never returns if one is stuck in the device.  torn_down is called after it.
+struct Worker_deleter
+{
+    std::function<void()> m_torn_down;
+
+    void operator()(Worker* worker) const
+    {
+        if (!m_torn_down)
+        {
+            delete worker;
+            return;
+        }
+        std::thread([worker, torn_down = m_torn_down]()
+        {
+            delete worker;
+            torn_down();
+        }).detach();
+    }
+};
+
+template<typename T, typename... Args>
+std::shared_ptr<Worker> make_worker(Args&&... args)
+{
+    return std::shared_ptr<T>(new T(std::forward<Args>(args)...), Worker_deleter{});
+}
+
+// a counter that grows as long as the worker mines
+std::uint64_t get_progress(config::Worker_config const& worker_config, std::variant<stats::Hash, stats::Prime> const& worker_stats)
+{
+    if (auto const hash_stats = std::get_if<stats::Hash>(&worker_stats))
+    {
+        //the fpga only reports the candidates it found
+        return worker_config.m_mode == config::Worker_mode::FPGA ? hash_stats->m_nonce_candidates_recieved : hash_stats->m_hash_count;
+    }
+    return std::get<stats::Prime>(worker_stats).m_range_searched;
+}
+}
+
 Worker_manager::Worker_manager(std::shared_ptr<asio::io_context> io_context, Config& config, 
     chrono::Timer_factory::Sptr timer_factory, network::Socket::Sptr socket)
 : m_io_context{std::move(io_context)}
 , m_config{config}
+, m_timer_factory{timer_factory}
 , m_socket{std::move(socket)}
 , m_logger{spdlog::get("logger")}
 , m_stats_collector{std::make_shared<stats::Collector>(m_config)}
 , m_timer_manager{std::move(timer_factory)}
+, m_watchdog{m_config.get_worker_config().size(), static_cast<double>(m_config.get_watchdog_stall_factor()),
+    std::chrono::seconds{m_config.get_watchdog_interval()}}
+, m_next_teardown_id{0}
+, m_nonce_allocator{std::make_shared<Nonce_allocator>()}
+, m_nbits{0}
+, m_stopped{false}
 {
     auto const& pool_config = m_config.get_pool_config();
     if(pool_config.m_use_pool)
@@ -118,69 +173,81 @@ void Worker_manager::create_workers()
     for(auto& worker_config : m_config.get_worker_config())
     {
         worker_config.m_internal_id = internal_id;
-        switch(worker_config.m_mode)
+        auto worker = create_worker(worker_config);
+        if (worker)
         {
-            case config::Worker_mode::FPGA:
+            m_workers.push_back(std::move(worker));
+            m_worker_ids.push_back(static_cast<std::uint16_t>(internal_id));
+        }
+        internal_id++;
+    }
+}
+
+std::shared_ptr<Worker> Worker_manager::create_worker(config::Worker_config& worker_config)
+{
+    switch(worker_config.m_mode)
+    {
+        case config::Worker_mode::FPGA:
+        {
+            if (m_config.get_mining_mode() == config::Mining_mode::PRIME)
             {
-                if (m_config.get_mining_mode() == config::Mining_mode::PRIME)
-                {
-                    m_logger->error("FPGA worker is not supported for PRIME mining!");
-                }
-                else
-                {
-                    m_workers.push_back(std::make_shared<fpga::Worker_hash>(m_io_context, worker_config));
-                }
-                break;
+                m_logger->error("FPGA worker is not supported for PRIME mining!");
             }
-            case config::Worker_mode::GPU:
+            else
             {
+                return make_worker<fpga::Worker_hash>(m_io_context, worker_config, m_nonce_allocator);
+            }
+            break;
+        }
+        case config::Worker_mode::GPU:
+        {
 #ifdef GPU_ENABLED
-                if (m_config.get_mining_mode() == config::Mining_mode::PRIME)
-                {
+            if (m_config.get_mining_mode() == config::Mining_mode::PRIME)
+            {
 #ifdef PRIME_ENABLED
-                    m_workers.push_back(std::make_shared<gpu::Worker_prime>(m_io_context, worker_config));
+                return make_worker<gpu::Worker_prime>(m_io_context, worker_config, m_nonce_allocator);
 #else
-                    m_logger->error("NexusMiner not built 'WITH_PRIME' -> no worker created!");
+                m_logger->error("NexusMiner not built 'WITH_PRIME' -> no worker created!");
 #endif
-                }
+            }
 #if defined(GPU_CUDA_ENABLED) && !defined(PRIME_ENABLED)
-                else
-                {
-                    m_workers.push_back(std::make_shared<gpu::Worker_hash>(m_io_context, worker_config));
-                }                
+            else
+            {
+                return make_worker<gpu::Worker_hash>(m_io_context, worker_config, m_nonce_allocator);
+            }                
 #elif defined(GPU_AMD_ENABLED) && !defined(PRIME_ENABLED)
-                m_logger->error("NexusMiner 'WITH_GPU_AMD' but not 'WITH_PRIME'.  Hash mode on AMD is not supported. -> no worker created!");
+            m_logger->error("NexusMiner 'WITH_GPU_AMD' but not 'WITH_PRIME'.  Hash mode on AMD is not supported. -> no worker created!");
 #endif
 #else
-                m_logger->error("NexusMiner not built 'WITH_GPU_CUDA' or 'WITH_GPU_AMD' -> no worker created!");
+            m_logger->error("NexusMiner not built 'WITH_GPU_CUDA' or 'WITH_GPU_AMD' -> no worker created!");
 #endif
-                break;
-            }
-            case config::Worker_mode::CPU:    // falltrough
-            default:
+            break;
+        }
+        case config::Worker_mode::CPU:    // falltrough
+        default:
+        {
+            if (m_config.get_mining_mode() == config::Mining_mode::PRIME)
             {
-                if (m_config.get_mining_mode() == config::Mining_mode::PRIME)
-                {
 #ifdef PRIME_ENABLED
-                    m_workers.push_back(std::make_shared<cpu::Worker_prime>(m_io_context, worker_config));
+                return make_worker<cpu::Worker_prime>(m_io_context, worker_config, m_nonce_allocator);
 #else
-                    m_logger->error("NexusMiner not built 'WITH_PRIME' -> no worker created!");
+                m_logger->error("NexusMiner not built 'WITH_PRIME' -> no worker created!");
 #endif
-                }
-                else
-                {
-                    m_workers.push_back(std::make_shared<cpu::Worker_hash>(m_io_context, worker_config));
-                }
-                break;
             }
+            else
+            {
+                return make_worker<cpu::Worker_hash>(m_io_context, worker_config, m_nonce_allocator);
+            }
+            break;
         }
-        internal_id++;
     }
+    return nullptr;
 }
 
 void Worker_manager::stop()
 {
     m_timer_manager.stop();
+    m_stopped = true;
 
     // close connection
     m_connection.reset();
@@ -188,8 +255,180 @@ void Worker_manager::stop()
     // destroy workers
     for(auto& worker : m_workers)
     {
+        worker->stop();
         worker.reset();
     }
+    m_workers.clear();
+    m_worker_ids.clear();
+    // the old workers are left to their threads
+    m_teardowns.clear();
+}
+
+void Worker_manager::check_workers()
+{
+    if (!m_block_found_handler)
+    {
+        // no block yet.  The workers are idle.
+        return;
+    }
+
+    auto const now = Worker_watchdog::Clock::now();
+    std::vector<std::uint16_t> stalled_workers;
+    for (std::size_t i = 0; i < m_workers.size(); i++)
+    {
+        auto const internal_id = m_worker_ids[i];
+        auto& worker_config = m_config.get_worker_config()[internal_id];
+        m_workers[i]->update_statistics(*m_stats_collector);
+        if (worker_config.m_mode == config::Worker_mode::FPGA && !m_config.get_watchdog_fpga())
+        {
+            continue;
+        }
+        auto const progress = get_progress(worker_config, m_stats_collector->get_worker_stats(internal_id));
+        if (m_workers[i]->idle())
+        {
+            m_watchdog.idle(internal_id, progress, now);
+            continue;
+        }
+        auto const verdict = m_watchdog.check(internal_id, progress, now);
+        if (verdict == Worker_watchdog::Verdict::ok)
+        {
+            continue;
+        }
+
+        if (verdict == Worker_watchdog::Verdict::reissue)
+        {
+            m_logger->warn("Worker {} stalled. Reissuing the current block.", worker_config.m_id);
+            m_workers[i]->set_block(m_block, m_nbits, m_block_found_handler, now);
+        }
+        else
+        {
+            m_logger->warn("Worker {} still stalled. Recreating the worker.", worker_config.m_id);
+            stalled_workers.push_back(internal_id);
+        }
+
+        stats::Global global_stats{};
+        global_stats.m_worker_recoveries = 1;
+        m_stats_collector->update_global_stats(global_stats);
+    }
+
+    for (auto const internal_id : stalled_workers)
+    {
+        recreate_worker(internal_id);
+    }
+}
+
+void Worker_manager::recreate_worker(std::uint16_t internal_id)
+{
+    // until the replacement is ready new blocks, the watchdog and the stats collector go without the worker
+    auto const worker_id = std::find(m_worker_ids.begin(), m_worker_ids.end(), internal_id);
+    auto const index = worker_id - m_worker_ids.begin();
+    auto worker = std::move(m_workers[index]);
+    m_workers.erase(m_workers.begin() + index);
+    m_worker_ids.erase(worker_id);
+    worker->stop();
+    // the stats collector timer holds the old workers
+    m_timer_manager.start_stats_collector_timer(m_config.get_print_statistics_interval(), m_workers, m_stats_collector);
+
+    // cpu workers share nothing with their replacement.  gpu and fpga workers would share the device or serial port.
+    bool const replace_when_done = m_config.get_worker_config()[internal_id].m_mode != config::Worker_mode::CPU;
+    auto const teardown_id = m_next_teardown_id++;
+    auto& teardown = m_teardowns[teardown_id];
+    teardown.m_internal_id = internal_id;
+    teardown.m_replace_when_done = replace_when_done;
+    teardown.m_timed_out = false;
+    teardown.m_deadline = m_timer_factory->create_timer();
+    std::weak_ptr<Worker_manager> weak_self = shared_from_this();
+    teardown.m_deadline->start(chrono::Seconds(teardown_timeout), [weak_self, teardown_id](bool canceled)
+    {
+        auto self = weak_self.lock();
+        if (!canceled && self)
+        {
+            self->teardown_timed_out(teardown_id);
+        }
+    });
+
+    // handlers queued on the io thread (results, the canceled stats collector timer) may still hold the worker.
+    // Whoever lets go of it last hands it to the teardown thread.
+    std::get_deleter<Worker_deleter>(worker)->m_torn_down = [weak_self, io_context = m_io_context, teardown_id]()
+    {
+        ::asio::post(*io_context, [weak_self, teardown_id]()
+        {
+            if (auto self = weak_self.lock())
+            {
+                self->teardown_done(teardown_id);
+            }
+        });
+    };
+    worker.reset();
+
+    if (!replace_when_done)
+    {
+        add_recreated_worker(internal_id);
+    }
+}
+
+void Worker_manager::teardown_done(std::uint64_t teardown_id)
+{
+    auto const teardown = m_teardowns.find(teardown_id);
+    if (teardown == m_teardowns.end())
+    {
+        return;
+    }
+    auto const internal_id = teardown->second.m_internal_id;
+    bool const replace = teardown->second.m_replace_when_done;
+    if (teardown->second.m_timed_out)
+    {
+        m_logger->info("Worker {} shut down after all.", m_config.get_worker_config()[internal_id].m_id);
+    }
+    m_teardowns.erase(teardown);
+    if (replace)
+    {
+        add_recreated_worker(internal_id);
+    }
+}
+
+void Worker_manager::teardown_timed_out(std::uint64_t teardown_id)
+{
+    auto const teardown = m_teardowns.find(teardown_id);
+    if (teardown == m_teardowns.end())
+    {
+        return;
+    }
+    // the old worker is left behind with its stuck threads.  A gpu or fpga worker is only recreated if it still shuts down.
+    teardown->second.m_timed_out = true;
+    auto const& worker_config = m_config.get_worker_config()[teardown->second.m_internal_id];
+    m_logger->error("Worker {} did not shut down within {} seconds and is unrecoverable.{}", worker_config.m_id, teardown_timeout,
+        teardown->second.m_replace_when_done ? " Mining without it." : "");
+
+    stats::Global global_stats{};
+    global_stats.m_workers_lost = 1;
+    m_stats_collector->update_global_stats(global_stats);
+}
+
+void Worker_manager::add_recreated_worker(std::uint16_t internal_id)
+{
+    if (m_stopped)
+    {
+        return;
+    }
+
+    auto& worker_config = m_config.get_worker_config()[internal_id];
+    auto worker = create_worker(worker_config);
+    if (!worker)
+    {
+        m_logger->error("Failed to recreate worker {}. Mining without it.", worker_config.m_id);
+        return;
+    }
+    m_logger->info("Worker {} recreated.", worker_config.m_id);
+    auto const now = Worker_watchdog::Clock::now();
+    m_watchdog.reset(internal_id, now);
+    if (m_block_found_handler)
+    {
+        worker->set_block(m_block, m_nbits, m_block_found_handler, now);
+    }
+    m_workers.push_back(std::move(worker));
+    m_worker_ids.push_back(internal_id);
+    m_timer_manager.start_stats_collector_timer(m_config.get_print_statistics_interval(), m_workers, m_stats_collector);
 }
 
 void Worker_manager::retry_connect(network::Endpoint const& wallet_endpoint)
@@ -238,6 +477,11 @@ bool Worker_manager::connect(network::Endpoint const& wallet_endpoint)
                     auto const print_statistics_interval = self->m_config.get_print_statistics_interval();
                     self->m_timer_manager.start_stats_collector_timer(print_statistics_interval, self->m_workers, self->m_stats_collector);
                     self->m_timer_manager.start_stats_printer_timer(print_statistics_interval, self->m_stats_printers);
+                    auto const watchdog_interval = self->m_config.get_watchdog_interval();
+                    if (watchdog_interval != 0)
+                    {
+                        self->m_timer_manager.start_watchdog_timer(watchdog_interval, self);
+                    }
 
                     auto const& pool_config = self->m_config.get_pool_config();
                     if (pool_config.m_use_pool)
@@ -255,19 +499,26 @@ bool Worker_manager::connect(network::Endpoint const& wallet_endpoint)
 
                     self->m_miner_protocol->set_block_handler([self, wallet_endpoint](auto block, auto nBits)
                     {
-                        for(auto& worker : self->m_workers)
+                        // the whole nonce space is free again
+                        self->m_nonce_allocator->new_block();
+                        self->m_block = block;
+                        self->m_nbits = nBits;
+                        self->m_block_found_handler = [self, wallet_endpoint](auto id, auto block_data)
                         {
-                            worker->set_block(block, nBits, [self, wallet_endpoint](auto id, auto block_data)
+                            if (self->m_connection)
+                                self->m_connection->transmit(self->m_miner_protocol->submit_block(
+                                    block_data->merkle_root.GetBytes(), block_data->nNonce));
+                            else
                             {
-                                if (self->m_connection)
-                                    self->m_connection->transmit(self->m_miner_protocol->submit_block(
-                                        block_data->merkle_root.GetBytes(), block_data->nNonce));
-                                else
-                                {
-                                    self->m_logger->error("No connection. Can't submit block.");
-                                    self->retry_connect(wallet_endpoint);
-                                }
-                            });
+                                self->m_logger->error("No connection. Can't submit block.");
+                                self->retry_connect(wallet_endpoint);
+                            }
+                        };
+                        // set_block only hands the block over.  Every worker switches on its own threads (or the fpga)
+                        // so all workers start on the block at about the same time.
+                        for(auto& worker : self->m_workers)
+                        {
+                            worker->set_block(block, nBits, self->m_block_found_handler, self->m_received);
                         }
                     });
                 }));
@@ -296,6 +547,7 @@ bool Worker_manager::connect(network::Endpoint const& wallet_endpoint)
 
 void Worker_manager::process_data(network::Shared_payload&& receive_buffer)
 {
+    m_received = std::chrono::steady_clock::now();
     auto remaining_size = receive_buffer->size();
     do
     {
@@ -8,17 +8,21 @@
 #include "chrono/timer_factory.hpp"
 #include "timer_manager.hpp"
 #include "stats/stats_printer.hpp"
+#include "nonce_allocator.hpp"
+#include "worker_watchdog.hpp"
+#include "worker.hpp"
 
+#include <chrono>
+#include <map>
 #include <memory>
 
 namespace asio { class io_context; }
 
 namespace nexusminer 
 {
-namespace config { class Config; }
+namespace config { class Config; class Worker_config; }
 namespace stats { class Collector; }
 namespace protocol { class Protocol; }
-class Worker;
 
 class Worker_manager : public std::enable_shared_from_this<Worker_manager>
 {
@@ -34,17 +38,31 @@ public:
     // stop the component and destroy all workers
     void stop();
 
+    // called by the watchdog timer.  Reissues the work of stalled workers or recreates them.
+    void check_workers();
+
 private:
 
     void process_data(network::Shared_payload&& receive_buffer);
 
     void create_stats_printers();
     void create_workers();
+    // nullptr if the worker is not supported by this build or mining mode
+    std::shared_ptr<Worker> create_worker(config::Worker_config& worker_config);
+    // takes a stalled worker out and destroys it off the io thread.  A cpu worker is replaced right away, a gpu or fpga worker
+    // once the old one released the device or serial port.
+    void recreate_worker(std::uint16_t internal_id);
+    void add_recreated_worker(std::uint16_t internal_id);
+    // the destructor of the old worker returned
+    void teardown_done(std::uint64_t teardown_id);
+    // the destructor of the old worker didn't return within teardown_timeout
+    void teardown_timed_out(std::uint64_t teardown_id);
 
     void retry_connect(network::Endpoint const& wallet_endpoint);
 
 	std::shared_ptr<::asio::io_context> m_io_context;
     Config& m_config;
+    chrono::Timer_factory::Sptr m_timer_factory;
 	network::Socket::Sptr m_socket;
 	network::Connection::Sptr m_connection;
     std::shared_ptr<spdlog::logger> m_logger;
@@ -54,6 +72,29 @@ private:
 
     std::vector<std::shared_ptr<stats::Printer>> m_stats_printers;
     std::vector<std::shared_ptr<Worker>> m_workers;
+    // internal id (index in the worker config) of each worker in m_workers
+    std::vector<std::uint16_t> m_worker_ids;
+    Worker_watchdog m_watchdog;
+    // old workers being destroyed by recreate_worker
+    struct Teardown
+    {
+        std::uint16_t m_internal_id;
+        // the replacement waits for the old worker
+        bool m_replace_when_done;
+        bool m_timed_out;
+        chrono::Timer::Uptr m_deadline;
+    };
+    std::map<std::uint64_t, Teardown> m_teardowns;
+    std::uint64_t m_next_teardown_id;
+    // nonce ranges (sieve offsets for prime) for all workers.  Starts over with every block.
+    std::shared_ptr<Nonce_allocator> m_nonce_allocator;
+    // arrival of the data process_data works on.  The block switch latency of the workers is measured from here.
+    std::chrono::steady_clock::time_point m_received;
+    // the current block.  Reissued to stalled workers.
+    LLP::CBlock m_block;
+    std::uint32_t m_nbits;
+    Worker::Block_found_handler m_block_found_handler;
+    bool m_stopped;
 };
 }
 